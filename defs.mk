@@ -166,11 +166,17 @@ MSRCS+=$R/samples/core/task_yield.c
 MSRCS+=$R/samples/core/task_suspend.c
 MSRCS+=$R/samples/core/errno.c
 MSRCS+=$R/samples/core/queue.c
+MSRCS+=$R/samples/core/queue_zero_copy.c
+MSRCS+=$R/samples/core/mailbox.c
+MSRCS+=$R/samples/core/bus.c
 MSRCS+=$R/samples/core/sem_counting.c
 MSRCS+=$R/samples/core/sem_flush.c
 MSRCS+=$R/samples/core/clockbug.c
 MSRCS+=$R/samples/core/mem_mgr.c
 MSRCS+=$R/samples/core/mem_pool.c
+MSRCS+=$R/samples/core/pool_free.c
+MSRCS+=$R/samples/core/pool_info.c
+MSRCS+=$R/samples/core/pool_magazine.c
 MSRCS+=$R/samples/core/deadman.c
 
 ##	If the memory is compiled under OSAL enable the test too
@@ -201,6 +207,10 @@ MSRCS+=$R/samples/misc/perm.c
 MSRCS+=$R/samples/misc/qsort.c
 MSRCS+=$R/samples/misc/queen.c
 MSRCS+=$R/samples/misc/sieve.c
+MSRCS+=$R/samples/misc/queue_bench.c
+ifeq ($(CONFIG_LINUX), y)
+MSRCS+=$R/samples/misc/queue_replay.c
+endif
 ifeq ($(CONFIG_RASTA), y)
 #MSRCS+=$R/samples/rasta-spw/echos.c
 #MSRCS+=$R/samples/rasta-spw/echoc.c
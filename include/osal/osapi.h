@@ -53,11 +53,13 @@ typedef uint64_t OS_ticks_t;
 #include "ostask.h"
 #include "osmut.h"
 #include "osqueue.h"
+#include "osmailbox.h"
 #include "ossem.h"
 #include "ostime.h"
 #include "ostimer.h"
 #include "osint.h"
 #include "ospool.h"
+#include "osbus.h"
 #include "osmemmgr.h"
 
 /** The filesystem API is declared in this header file  */
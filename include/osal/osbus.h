@@ -0,0 +1,165 @@
+/**
+ *  \file   osbus.h
+ *  \brief  This file defines the software bus interface, which publishes
+ *  messages to the queues subscribed to their message ID
+ *
+ *  Messages are written once in a buffer of a memory pool and each
+ *  subscriber queue receives a pointer to it. The buffer counts its
+ *  references and goes back to its pool when the last subscriber releases
+ *  it.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: osbus.h 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#ifndef _OSAL_BUS_H_
+#define _OSAL_BUS_H_
+
+/**
+ *  \ingroup OSAL
+ *  \defgroup Bus_API Library Software Bus API
+ *
+ *  This API contain a set of functions for publishing messages to the queues
+ *  subscribed to them without copying the messages.
+ */
+
+/*-----------------------------------------------------------------------------
+ *  OS SOFTWARE BUS INTERFACE
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * \ingroup Bus_API
+ * \brief Bytes of every bus buffer taken by the reference count and the
+ * message information stored in front of the message.
+ */
+#define OS_BUS_BUFFER_OVERHEAD  (16)
+
+/**
+ * \ingroup Bus_API
+ * \brief Size of the pool buffers holding messages of up to 'size' bytes,
+ * to be given to \ref OS_PoolCreate().
+ */
+#define OS_BUS_BUFFER_SIZE(size)    ((size) + OS_BUS_BUFFER_OVERHEAD)
+
+/**
+ * \ingroup Bus_API
+ * \brief Message size of the subscriber queues, which receive a pointer to
+ * the bus buffer.
+ */
+#define OS_BUS_MSG_SIZE         (sizeof(void *))
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call subscribes a queue to the messages published with the
+ *  message ID 'ul_MsgId'.
+ *
+ *  The queue shall be read with \ref OS_BusReceive() and hold messages of
+ *  \ref OS_BUS_MSG_SIZE bytes, a queue of smaller messages is rejected with
+ *  OS_STATUS_EINVAL. A queue may be subscribed to several message
+ *  IDs. A message ID routes to up to \ref OS_MAX_BUS_SUBSCRIBERS queues and
+ *  the bus routes up to \ref OS_MAX_BUS_ROUTES message IDs.
+ *
+ *  \param  ul_MsgId    Message identifier
+ *  \param  ul_QueueId  Subscriber queue identifier
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_BusSubscribe(uint32_t ul_MsgId, uint32_t ul_QueueId);
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call removes the subscription of a queue to the message ID
+ *  'ul_MsgId'. The messages already queued are still to be released.
+ *
+ *  \param  ul_MsgId    Message identifier
+ *  \param  ul_QueueId  Subscriber queue identifier
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_BusUnsubscribe(uint32_t ul_MsgId, uint32_t ul_QueueId);
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call obtains a buffer from the memory pool 'ul_PoolId' for a
+ *  message to be published.
+ *
+ *  The pool buffers shall be \ref OS_BUS_BUFFER_SIZE() bytes. The buffer
+ *  belongs to the caller until it is published, or released with
+ *  \ref OS_BusRelease().
+ *
+ *  \param  ul_PoolId   Memory pool identifier
+ *  \param  ppv_Buffer  The message buffer returned
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_BusGetBuffer(uint32_t ul_PoolId, void **ppv_Buffer);
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call publishes the message in 'pv_Buffer' to every queue
+ *  subscribed to 'ul_MsgId'.
+ *
+ *  Each subscriber queue receives a pointer to the buffer, which is not
+ *  copied. The publisher gives the buffer away in any case; it goes back to
+ *  its pool when there is no subscriber or the last subscriber releases it.
+ *
+ *  \param  ul_MsgId    Message identifier
+ *  \param  pv_Buffer   Buffer obtained with \ref OS_BusGetBuffer()
+ *  \param  ul_Size     Size of the message
+ *  \param  ul_Prio     Priority of the message in the subscriber queues
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error. OS_STATUS_QUEUE_FULL tells some
+ * subscriber queues could not take the message, the others did.
+ */
+int OS_BusPublish(uint32_t ul_MsgId, void *pv_Buffer, uint32_t ul_Size, uint32_t ul_Prio);
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call receives the next message of a subscriber queue.
+ *
+ *  The buffer is shared with the other subscribers and shall not be
+ *  modified. It shall be given back with \ref OS_BusRelease().
+ *
+ *  \param  ul_QueueId  Subscriber queue identifier
+ *  \param  ppv_Buffer  The message buffer received
+ *  \param  pul_MsgId   The message identifier it was published with
+ *  \param  pul_Size    The size of the message
+ *  \param  l_Timeout   This is the timeout, as for \ref OS_QueueGet()
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_BusReceive(
+        uint32_t ul_QueueId, 
+        void **ppv_Buffer, 
+        uint32_t *pul_MsgId, 
+        uint32_t *pul_Size, 
+        int32_t l_Timeout);
+
+/**
+ * \ingroup Bus_API
+ *  \brief This call drops a reference to a bus buffer, which goes back to
+ *  its pool with the last one.
+ *
+ *  \param  pv_Buffer   Buffer received or obtained and not published
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_BusRelease(void *pv_Buffer);
+
+#endif
@@ -47,6 +47,27 @@
 #define OS_MAX_QUEUES           CONFIG_MAX_NUMBER_OF_QUEUES
 /** Maximum number of queues in the OS  */
 #define OS_MAX_POOLS            CONFIG_MAX_NUMBER_OF_POOLS
+/** Is the number of buffers of every pool each task caches, so most of its
+ * OS_GetPoolBuffer() and OS_ReturnPoolBuffer() calls take no shared lock.
+ * Zero disables the caches */
+#define OS_POOL_MAGAZINE_SIZE   16
+/** Is the time, in milliseconds, a slab of a growable pool stays with all
+ * its buffers free before it is given back to the heap, see
+ * OS_PoolCreateGrowable() */
+#define OS_POOL_SLAB_HYSTERESIS 1000
+/** Is the number of entries of the index OS_FreeBuffer() finds the pool of
+ * a buffer in. It shall be a power of two, the memory of every pool takes
+ * at least one entry and every slab of the growable pools two more. The
+ * growable pools check the buffers returned with the lock held when the
+ * index is too small */
+#define OS_POOL_INDEX_SIZE      256
+/** Is the time, in milliseconds, the allocation and return rates of the
+ * pools are averaged over, see OS_PoolGetInfo() */
+#define OS_POOL_RATE_WINDOW     1000
+/** Is the maximum number of size class allocators, see OS_PoolCreateClasses() */
+#define OS_MAX_POOL_CLASS_SETS  4
+/** Is the maximum number of size classes of an allocator */
+#define OS_MAX_POOL_CLASSES     16
 /** Maximum number of binary sempahores in the OS  */
 #define OS_MAX_BIN_SEMAPHORES   CONFIG_MAX_NUMBER_OF_SEMAPHORES
 /** Maximum number of counting sempahores in the OS  */
@@ -55,6 +76,17 @@
 #define OS_MAX_SEMAPHORES		OS_MAX_BIN_SEMAPHORES
 /** Is the maximum number of mutexes that can be concurrently active */
 #define OS_MAX_MUTEXES          (CONFIG_MAX_NUMBER_OF_MUTEX + INTERNAL_MUTEX)
+/** Is the maximum number of tasks that can be concurrently waiting in
+ * OS_QueueSelect(). Each of them takes a binary semaphore the first time */
+#define OS_MAX_QUEUE_SELECTS    8
+/** Is the number of message IDs the software bus can route. It shall be a
+ * power of two */
+#define OS_MAX_BUS_ROUTES       64
+/** Is the maximum number of queues subscribed to one message ID of the
+ * software bus */
+#define OS_MAX_BUS_SUBSCRIBERS  8
+/** Is the maximum number of mailboxes that can be concurrently active */
+#define OS_MAX_MAILBOXES        16
 /** Is the maximum number of timers that can be concurrently active */
 #define OS_MAX_TIMERS           CONFIG_MAX_NUMBER_OF_TIMERS
 
@@ -103,6 +103,14 @@ typedef struct
     uint32_t mul_Creator;
 }OS_mut_sem_prop_t;
 
+/**
+ *  Number of entries of the queue latency histogram. Entry 0 counts the
+ *  messages retrieved within the microsecond they were queued and entry 'i'
+ *  the ones that waited [2^(i-1), 2^i) microseconds, the last entry also
+ *  counting any longer wait.
+ */
+#define OS_QUEUE_LATENCY_BUCKETS    24
+
 /**
  *  \class OS_qs class structure defines the OS queue informaton. This class is
  *  used by the \ref OS_QueueGetInfo() function
@@ -111,8 +119,57 @@ typedef struct
 {
     /** Queue Creator Identifier */
     uint32_t mul_Creator;
+    /** Largest message the queue takes, in bytes */
+    uint32_t mul_DataSize;
+    /** Messages currently queued */
+    uint32_t mul_Depth;
+    /** Highest number of messages queued since the queue creation */
+    uint32_t mul_PeakDepth;
+    /** Messages queued since the queue creation */
+    uint32_t mul_Puts;
+    /** Messages retrieved since the queue creation */
+    uint32_t mul_Gets;
+    /** Messages rejected because the queue was full */
+    uint32_t mul_Drops;
+    /** Messages discarded by an OS_QUEUE_OVERWRITE queue to store newer ones */
+    uint32_t mul_Overwrites;
+    /** Messages discarded by an OS_QUEUE_DROP_EXPIRED queue past their deadline */
+    uint32_t mul_Expired;
+    /** Histogram of the time the retrieved messages waited in the queue */
+    uint32_t mul_Latency[OS_QUEUE_LATENCY_BUCKETS];
 }OS_queue_prop_t;
 
+/**
+ * \brief Usage of a memory pool, see OS_PoolGetInfo(). The buffers cached
+ * by the tasks, see OS_POOL_MAGAZINE_SIZE, count as taken from the pool.
+ */
+typedef struct
+{
+    /** Size of the buffers */
+    uint32_t mul_BufferSize;
+    /** Buffers of the pool, the ones the growable pools can grow to */
+    uint32_t mul_Buffers;
+    /** Buffers currently taken from the pool */
+    uint32_t mul_Allocated;
+    /** Buffers taken from the pool cached by the tasks */
+    uint32_t mul_Cached;
+    /** Highest number of buffers taken from the pool since its creation */
+    uint32_t mul_PeakAllocated;
+    /** Buffers handed out since the pool creation */
+    uint32_t mul_Allocs;
+    /** Buffers returned since the pool creation */
+    uint32_t mul_Frees;
+    /** Buffers not handed out because the pool was exhausted */
+    uint32_t mul_Failures;
+    /** Buffers handed out per second over the last OS_POOL_RATE_WINDOW */
+    uint32_t mul_AllocRate;
+    /** Buffers returned per second over the last OS_POOL_RATE_WINDOW */
+    uint32_t mul_FreeRate;
+    /** Buffers held by every task of an OS_POOL_TRACK_OWNERS pool, the last
+     * entry counting the ones held outside the OSAL tasks */
+    uint32_t mul_Held[OS_MAX_TASKS + 1];
+}OS_pool_prop_t;
+
 /** 
  * \brief This class structure defines the information related to time. It is
  * used for some of the functions in the library
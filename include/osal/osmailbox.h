@@ -0,0 +1,115 @@
+/**
+ *  \file   osmailbox.h
+ *  \brief  This file defines the mailbox interface, which hands the latest
+ *  value written over to any number of readers
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: osmailbox.h 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#ifndef _OSAL_MAILBOX_H_
+#define _OSAL_MAILBOX_H_
+
+/**
+ *  \ingroup OSAL
+ *  \defgroup Mailbox_API Library Mailbox API
+ *
+ *  This API contain a set of functions handing the latest value of some
+ *  data, such as a state vector, from the writing tasks over to the reading
+ *  ones. A write replaces the previous value and never blocks, a read copies
+ *  the latest value without taking any lock.
+ */
+
+/*-----------------------------------------------------------------------------
+ *  OS MAILBOX INTERFACE
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * \ingroup Mailbox_API
+ * \brief Size of the buffer required by \ref OS_MailboxCreate() to hold
+ * values of up to 'size' bytes. The mailbox keeps two copies of the value.
+ */
+#define OS_MAILBOX_BUFFER_SIZE(size) \
+    (2 * (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1)))
+
+/**
+ * \ingroup Mailbox_API
+ *  \brief This call creates a mailbox holding values of up to 'ul_DataSize'
+ *  bytes.
+ *
+ *  \param  pul_MailboxId   The mailbox identifier returned
+ *  \param  pv_Buffer       Memory where the values are stored
+ *  \param  ul_BufferSize   Size of 'pv_Buffer', see \ref OS_MAILBOX_BUFFER_SIZE()
+ *  \param  ul_DataSize     Maximum size of the values
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_MailboxCreate(
+        uint32_t *pul_MailboxId, 
+        void *pv_Buffer, 
+        uint32_t ul_BufferSize, 
+        uint32_t ul_DataSize);
+
+/**
+ * \ingroup Mailbox_API
+ *  \brief This call deletes a mailbox. No task shall be using it.
+ *
+ *  \param  ul_MailboxId    Mailbox identifier
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_MailboxDelete(uint32_t ul_MailboxId);
+
+/**
+ * \ingroup Mailbox_API
+ *  \brief This call replaces the value of a mailbox. It never blocks; the
+ *  writers of the same mailbox are just serialized.
+ *
+ *  \param  ul_MailboxId    Mailbox identifier
+ *  \param  pv_Data         The value
+ *  \param  ul_Size         Size of the value
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_MailboxWrite(uint32_t ul_MailboxId, void *pv_Data, uint32_t ul_Size);
+
+/**
+ * \ingroup Mailbox_API
+ *  \brief This call copies the latest value of a mailbox.
+ *
+ *  The copy is consistent, it is never mixed with a value written
+ *  meanwhile. The value is left in the mailbox for the next reads.
+ *
+ *  \param  ul_MailboxId    Mailbox identifier
+ *  \param  pv_Data         Buffer for the value
+ *  \param  ul_Size         Size of 'pv_Data'
+ *  \param  pul_SizeCopied  Size of the value copied
+ *  \param  pul_Writes      Number of values written to the mailbox so far,
+ *                          modulo 2^31, telling whether the value is a new
+ *                          one, unless NULL
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error. OS_STATUS_QUEUE_EMPTY tells no value
+ * was written yet.
+ */
+int OS_MailboxRead(
+        uint32_t ul_MailboxId, 
+        void *pv_Data, 
+        uint32_t ul_Size, 
+        size_t *pul_SizeCopied,
+        uint32_t *pul_Writes);
+
+#endif
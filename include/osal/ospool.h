@@ -33,6 +33,43 @@
  *  OS MEMORY POOL INTERFACE
  *-----------------------------------------------------------------------------*/
 
+/**
+ * \ingroup Pool_API
+ * \brief Pool creation flag selecting a lock-free free list.
+ *
+ * The buffers are taken and given back with a compare-and-swap on a 64-bit
+ * word holding the index of the first free buffer and a generation number,
+ * so the calls never wait for a lock and are safe from the ABA problem. The
+ * per-task caches of \ref OS_POOL_MAGAZINE_SIZE are not used. The buffer
+ * size is rounded up to a multiple of 4 bytes.
+ */
+#define OS_POOL_LOCKFREE        (0x01)
+
+/**
+ * \ingroup Pool_API
+ * \brief Pool creation flag moving the clearing of the buffers out of
+ * \ref OS_GetPoolBuffer().
+ *
+ * The buffers returned are not given back to the free list until
+ * \ref OS_PoolScrub() clears them, typically from a low priority task when
+ * the system is idle, so \ref OS_GetPoolBuffer() takes cleared buffers. It
+ * only clears a buffer itself when no cleared one is left. The memory of the
+ * pool is cleared on creation. The per-task caches of
+ * \ref OS_POOL_MAGAZINE_SIZE are not used. Can not be combined with
+ * \ref OS_POOL_LOCKFREE.
+ */
+#define OS_POOL_ZERO_ON_FREE    (0x02)
+
+/**
+ * \ingroup Pool_API
+ * \brief Pool creation flag recording the task every buffer was taken by.
+ *
+ * \ref OS_PoolGetInfo() then reports the buffers every task holds, to find
+ * the task leaking them. Every take and return of a buffer also updates the
+ * tag of the buffer and a counter shared by the tasks.
+ */
+#define OS_POOL_TRACK_OWNERS    (0x04)
+
 /**
  * \ingroup Pool_API
  *  \brief This function creates a memory pool of fixed size buffers from a
@@ -43,6 +80,8 @@
  *  \param  ul_BufSize Fixed size of the buffer that can be allocated from the
  *  memory pool
  *  \param  pul_PoolId  Pool identifier returned
+ *  \param  ul_Flags   OS_POOL_LOCKFREE, OS_POOL_ZERO_ON_FREE,
+ *  OS_POOL_TRACK_OWNERS or zero
  *
  * \return Upon successful the function returns '0' otherwise -1 is returned and
  * os_errno is set to indicate the error.
@@ -51,13 +90,76 @@ int OS_PoolCreate(
         void *pv_Address, 
         uint32_t ul_Size, 
         uint32_t ul_BufSize, 
-        uint32_t *pul_PoolId);
+        uint32_t *pul_PoolId,
+        uint32_t ul_Flags);
+
+#if defined(CONFIG_LINUX)
+
+/**
+ * \ingroup Pool_API
+ *  \brief This function creates a memory pool of 'ul_Count' fixed size
+ *  buffers in memory allocated by the call.
+ *
+ *  The memory is mapped on huge pages when the system has them left, and on
+ *  regular pages otherwise. It is prefaulted and, when the process is
+ *  allowed to, locked in memory, so taking the buffers never faults. The
+ *  buffer size is rounded up to a multiple of the cache line size so every
+ *  buffer starts a cache line. \ref OS_PoolDelete() unmaps the memory.
+ *
+ *  \param  ul_Count   Number of buffers of the pool
+ *  \param  ul_BufSize Size of the buffers
+ *  \param  pul_PoolId Pool identifier returned
+ *  \param  ul_Flags   OS_POOL_LOCKFREE, OS_POOL_ZERO_ON_FREE,
+ *  OS_POOL_TRACK_OWNERS or zero
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolCreateAuto(
+        uint32_t ul_Count, 
+        uint32_t ul_BufSize, 
+        uint32_t *pul_PoolId,
+        uint32_t ul_Flags);
+
+#endif
+
+/**
+ * \ingroup Pool_API
+ *  \brief This function creates a memory pool of fixed size buffers growing
+ *  as it runs out of them.
+ *
+ *  The memory is taken from the heap in slabs of at least 'ul_SlabBuffers'
+ *  buffers, the first one by this call, until the pool holds
+ *  'ul_MaxBuffers' buffers rounded up to whole slabs. A slab with all its
+ *  buffers free during \ref OS_POOL_SLAB_HYSTERESIS milliseconds goes back
+ *  to the heap, but the last one. The size of the slabs is a power of two
+ *  they are aligned to, so the slab of a buffer is found in constant time.
+ *
+ *  \param  ul_BufSize      Size of the buffers
+ *  \param  ul_SlabBuffers  Minimum number of buffers of every slab
+ *  \param  ul_MaxBuffers   Maximum number of buffers of the pool
+ *  \param  pul_PoolId      Pool identifier returned
+ *  \param  ul_Flags        OS_POOL_ZERO_ON_FREE, OS_POOL_TRACK_OWNERS or
+ *  zero
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolCreateGrowable(
+        uint32_t ul_BufSize, 
+        uint32_t ul_SlabBuffers, 
+        uint32_t ul_MaxBuffers, 
+        uint32_t *pul_PoolId,
+        uint32_t ul_Flags);
 
 /**
  * \ingroup Pool_API
  *  \brief This call deletes the pool associated with the provided id.
  *
  *  The pool is only deleted if all the buffers have been previously returned.
+ *  The buffers returned and still cached by the tasks, see
+ *  \ref OS_POOL_MAGAZINE_SIZE, are given back to the pool. The slabs of the
+ *  growable pools go back to the heap.
  *
  *  \param  ul_PoolId  Pool identifier
  *
@@ -81,6 +183,22 @@ int OS_PoolDelete(uint32_t ul_PoolId);
  */
 int OS_GetPoolBuffer(uint32_t ul_PoolId, void **buffer);
 
+/**
+ * \ingroup Pool_API
+ *  \brief This call obtains a buffer from the memory pool specified by the
+ *  'ul_PoolId' without clearing it.
+ *
+ *  Meant for the buffers the caller overwrites anyway. The buffers of the
+ *  \ref OS_POOL_ZERO_ON_FREE pools not cleared yet are taken first.
+ *
+ *  \param  ul_PoolId  Memory pool identifier
+ *  \param  ppv_Buffer The buffer returned from the memory pool
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_GetPoolBufferNoZero(uint32_t ul_PoolId, void **buffer);
+
 /**
  * \ingroup Pool_API
  *  \brief This directive returns the buffer speficied by 'pv_Buffer' to the
@@ -94,6 +212,133 @@ int OS_GetPoolBuffer(uint32_t ul_PoolId, void **buffer);
  */
 int OS_ReturnPoolBuffer(uint32_t ul_PoolId, void *pv_Buffer);
 
+/**
+ * \ingroup Pool_API
+ *  \brief This call returns the buffer specified by 'pv_Buffer' to the
+ *  memory pool or size class allocator it was obtained from.
+ *
+ *  The owner of the buffer is looked up by address in constant time, so
+ *  the buffers can be released without their pool identifier, as
+ *  \ref OS_ReturnPoolBuffer() and \ref OS_PoolFree() do.
+ *
+ *  \param  pv_Buffer  Buffer to be returned
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_FreeBuffer(void *pv_Buffer);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This function retrieves the usage of the pool 'ul_PoolId'.
+ *
+ *  The counters are read without stopping the users of the pool, so the
+ *  figures may be off by the buffers in flight.
+ *
+ *  \param  ul_PoolId      Pool identifier
+ *  \param  pt_PoolProp    Structure where the usage will be stored
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolGetInfo(uint32_t ul_PoolId, OS_pool_prop_t *pt_PoolProp);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This call clears the buffers returned to the
+ *  \ref OS_POOL_ZERO_ON_FREE pool 'ul_PoolId' and makes them available to
+ *  \ref OS_GetPoolBuffer() again.
+ *
+ *  The pool lock is only held for a few buffers at a time, so the call can
+ *  run from a low priority task without delaying the other users of the
+ *  pool.
+ *
+ *  \param  ul_PoolId   Memory pool identifier
+ *  \param  ul_Max      Maximum number of buffers to clear, zero for all
+ *  \param  pul_Cleared Number of buffers cleared, may be NULL
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolScrub(uint32_t ul_PoolId, uint32_t ul_Max, uint32_t *pul_Cleared);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This function creates an allocator of buffers of several size
+ *  classes from a single memory space statically provided in the call.
+ *
+ *  Each class is a lock-free pool (see \ref OS_POOL_LOCKFREE) of the
+ *  requested number of buffers, laid out one after the other in the memory.
+ *  The class sizes are rounded up to a multiple of 4 bytes and each class
+ *  starts at a multiple of 8 bytes from 'pv_Address', so the buffers keep its
+ *  alignment, up to 8 bytes, when the sizes are multiples of 8. The memory
+ *  must hold every class, otherwise OS_STATUS_EINVAL is returned; any memory
+ *  left over is not used.
+ *
+ *  \param  pv_Address     Starting address of the memory of the allocator
+ *  \param  ul_Size        Size of the memory
+ *  \param  aul_ClassSizes Buffer sizes of the classes, in increasing order,
+ *  for example 32 bytes to 4 Kbytes in powers of two
+ *  \param  aul_ClassBuffers Number of buffers of each class
+ *  \param  ul_Classes     Number of classes, up to \ref OS_MAX_POOL_CLASSES
+ *  \param  pul_ClassesId  Allocator identifier returned
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolCreateClasses(
+        void *pv_Address, 
+        uint32_t ul_Size, 
+        const uint32_t aul_ClassSizes[], 
+        const uint32_t aul_ClassBuffers[], 
+        uint32_t ul_Classes, 
+        uint32_t *pul_ClassesId);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This call deletes the allocator associated with the provided id.
+ *
+ *  The allocator is only deleted if all the buffers have been previously
+ *  freed.
+ *
+ *  \param  ul_ClassesId   Allocator identifier
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolDeleteClasses(uint32_t ul_ClassesId);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This call obtains a buffer of at least 'ul_Size' bytes from the
+ *  smallest class fitting it, or from the next ones when that class is
+ *  exhausted.
+ *
+ *  The class is found with a lookup table in constant time. Unlike
+ *  \ref OS_GetPoolBuffer(), the buffer is not cleared.
+ *
+ *  \param  ul_ClassesId   Allocator identifier
+ *  \param  ul_Size        Size requested
+ *  \param  ppv_Buffer     The buffer returned
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolAlloc(uint32_t ul_ClassesId, uint32_t ul_Size, void **ppv_Buffer);
+
+/**
+ * \ingroup Pool_API
+ *  \brief This call gives a buffer obtained with \ref OS_PoolAlloc() back
+ *  to its class.
+ *
+ *  \param  ul_ClassesId   Allocator identifier
+ *  \param  pv_Buffer      Buffer to be freed
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_PoolFree(uint32_t ul_ClassesId, void *pv_Buffer);
+
 
 
 #endif
@@ -39,6 +39,123 @@
  *  creation and handling of queues.
  */
 
+/**
+ * \ingroup Queue_API
+ * \brief Upper bound of the bookkeeping bytes every message takes from the
+ * queue buffer on top of its (pointer-aligned) payload.
+ */
+#define OS_QUEUE_MSG_OVERHEAD   (48)
+
+/**
+ * \ingroup Queue_API
+ * \brief Number of message priority levels. Messages with higher priority
+ * values are retrieved first; priorities above the last level are queued in
+ * the last level.
+ */
+#define OS_QUEUE_PRIO_LEVELS    (32)
+
+/**
+ * \ingroup Queue_API
+ * \brief Size of the buffer required by \ref OS_QueueCreate() to store 'depth'
+ * messages of up to 'size' bytes.
+ */
+#define OS_QUEUE_BUFFER_SIZE(depth, size) \
+    ((depth) * ((((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1)) + \
+                OS_QUEUE_MSG_OVERHEAD))
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag selecting a lock-free ring for queues with
+ * exactly one producer task and one consumer task.
+ *
+ * Messages are retrieved in FIFO order and their priority is ignored. The
+ * consumer only blocks on the queue semaphore when the ring is empty. A
+ * message borrowed with \ref OS_QueueBorrow() stays at the head of the ring
+ * until it is released, the gets and borrows fail with OS_STATUS_EBUSY
+ * meanwhile.
+ */
+#define OS_QUEUE_SPSC           (0x2)
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag selecting a bounded lock-free ring for queues
+ * written and read by any number of tasks.
+ *
+ * Messages are retrieved in FIFO order and their priority is ignored. The
+ * ring holds the largest power of two of messages that fits the buffer and
+ * the queue depth, so a power of two depth is recommended. A slot reserved
+ * with \ref OS_QueueReserve() delays the consumers of the messages queued
+ * after it until it is committed or released.
+ */
+#define OS_QUEUE_MPMC           (0x4)
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag selecting a ring of variable size messages for
+ * queues written and read by any number of tasks.
+ *
+ * Messages are packed one after the other in the queue buffer, each one
+ * taking its (pointer-aligned) payload plus \ref OS_QUEUE_VAR_MSG_OVERHEAD
+ * bytes, so the buffer use follows the actual size of the messages rather
+ * than the maximum one. Messages are retrieved in FIFO order and their
+ * priority is ignored. The number of pending messages is only bounded by
+ * the buffer size. \ref OS_QueueReserve() takes room for the largest message
+ * and \ref OS_QueueCommit() gives back the unused part when no other message
+ * was reserved meanwhile.
+ */
+#define OS_QUEUE_VARIABLE       (0x8)
+
+/**
+ * \ingroup Queue_API
+ * \brief Upper bound of the bookkeeping bytes every message of an
+ * \ref OS_QUEUE_VARIABLE queue takes from the queue buffer.
+ */
+#define OS_QUEUE_VAR_MSG_OVERHEAD   (16)
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag making the producers of a full queue discard the
+ * oldest message of the lowest priority level to store the new one.
+ *
+ * Meant for housekeeping queues where the freshest samples matter most:
+ * \ref OS_QueuePut(), \ref OS_QueuePutMany() and \ref OS_QueueReserve()
+ * never wait for the consumers and only report the queue full when no slot
+ * holds a message waiting for a consumer. The discarded messages are counted
+ * in the queue information. It can not be combined with the ring flags.
+ */
+#define OS_QUEUE_OVERWRITE      (0x10)
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag retrieving the messages in earliest deadline
+ * first order rather than by static priority.
+ *
+ * The priority given when a message is queued is its relative deadline in
+ * milliseconds, up to \ref OS_QUEUE_MAX_DEADLINE, and the queue keeps the
+ * absolute deadline. Messages with the same deadline are retrieved in FIFO
+ * order. Insertion and removal take O(log n); each message takes a pointer
+ * more of the queue buffer, which \ref OS_QUEUE_BUFFER_SIZE() accounts for.
+ */
+#define OS_QUEUE_DEADLINE       (0x20)
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue creation flag making the \ref OS_QUEUE_DEADLINE queues discard
+ * the messages whose deadline has passed when they would be retrieved.
+ *
+ * The discarded messages are counted in the queue information and the get
+ * calls keep waiting for a message still on time, starting their timeout
+ * over.
+ */
+#define OS_QUEUE_DROP_EXPIRED   (0x40)
+
+/**
+ * \ingroup Queue_API
+ * \brief Longest relative deadline, in milliseconds, of the messages of the
+ * \ref OS_QUEUE_DEADLINE queues. Longer deadlines are cut down to it.
+ */
+#define OS_QUEUE_MAX_DEADLINE   (1800000)
+
 /****************************************************************************************
   QUEUE API
  ****************************************************************************************/
@@ -49,10 +166,12 @@
  * \param pul_QueueId    an id to refer to a specific queue, is passed back to the caller
  * 
  * \param pc_QueueBuffer  This input parameter shall point to the queue message
- * buffer provided by the service user.
+ * buffer provided by the service user. The message descriptors are carved from
+ * this buffer as well, so each queue owns all the storage it needs.
  *
  * \param ul_QueueBufSize This input parameter shall contain the size of the
- * queue buffer.
+ * queue buffer. Use \ref OS_QUEUE_BUFFER_SIZE() to hold ul_QueueDepht
+ * messages; a smaller buffer reduces the number of pending messages.
  *
  * \param ul_QueueDepht This is the maximum number of elements that can be 
  *                     stored in the queue.
@@ -62,11 +181,17 @@
  *                     it is the maximum size.
  * \param ul_Flags       This is for extra queue creation flags. The current 
  *                     flags are
- *                     OS_FIFO_QUEUE – use the FIFO queue policy ( default )
- *                     OS_PRIORITY_QUEUE – use priority based queue policy
- *                     OS_FIXED_SIZE_QUEUE
- *                     OS_VARIABLE_SIZED_QUEUE
- *                     This flag capability is not implemented yet.
+ *                     OS_NONBLOCKING – gets do not wait when no timeout is given
+ *                     \ref OS_QUEUE_SPSC – single-producer/single-consumer
+ *                     lock-free FIFO ring
+ *                     \ref OS_QUEUE_MPMC – multi-producer/multi-consumer
+ *                     lock-free FIFO ring
+ *                     \ref OS_QUEUE_VARIABLE – FIFO ring of variable size
+ *                     messages
+ *                     \ref OS_QUEUE_OVERWRITE – full queues discard their
+ *                     oldest message
+ *                     \ref OS_QUEUE_DEADLINE – earliest deadline first
+ *                     retrieval, with \ref OS_QUEUE_DROP_EXPIRED
  * 
  * \return Upon successful the function returns '0' otherwise -1 is returned and
  * os_errno is set to indicate the error.
@@ -80,6 +205,144 @@ int OS_QueueCreate (
         uint32_t ul_DataSize, 
         uint32_t ul_Flags);
 
+#if defined(CONFIG_LINUX)
+
+/**
+ * \ingroup Queue_API
+ * \brief Longest name of the shared queues, terminating null included.
+ */
+#define OS_QUEUE_NAME_MAX       (32)
+
+/**
+ * \ingroup Queue_API
+ * \brief Create a message queue which other processes can attach to by name.
+ *
+ * The queue is a \ref OS_QUEUE_MPMC ring whose slots, indices and counting
+ * semaphores are placed in a POSIX shared memory object, so a message costs
+ * a copy in and a copy out and no system call when no task is waiting. The
+ * memory is allocated by the call, no queue buffer is needed.
+ *
+ * The queue telemetry counts the calls of each process, the depth excepted.
+ * The shared queues can not be waited on with \ref OS_QueueSelect().
+ *
+ * \param pul_QueueId  an id to refer to the queue, is passed back to the caller
+ * \param pc_Name      This is the name of the shared memory object, starting
+ *                     with '/' and shorter than \ref OS_QUEUE_NAME_MAX
+ * \param ul_QueueDepht This is the maximum number of elements that can be
+ *                     stored in the queue, rounded up to a power of two.
+ * \param ul_DataSize  This is the maximum size of the messages.
+ * \param ul_Flags     OS_NONBLOCKING or zero
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_QueueCreateShared (
+        uint32_t *pul_QueueId, 
+        const char *pc_Name,
+        uint32_t ul_QueueDepht, 
+        uint32_t ul_DataSize, 
+        uint32_t ul_Flags);
+
+/**
+ * \ingroup Queue_API
+ * \brief Attach to a message queue created by another process with
+ * \ref OS_QueueCreateShared().
+ *
+ * \ref OS_QueueDelete() detaches the calling process. When the creator
+ * deletes the queue its name is removed and the processes still attached
+ * keep using it.
+ *
+ * \param pul_QueueId  an id to refer to the queue, is passed back to the caller
+ * \param pc_Name      This is the name the queue was created with
+ * \param ul_Flags     OS_NONBLOCKING or zero, for the calls of this process
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error. OS_STATUS_EBUSY tells the queue is
+ * still being created.
+ */
+int OS_QueueAttach (uint32_t *pul_QueueId, const char *pc_Name, uint32_t ul_Flags);
+
+/**
+ * \ingroup Queue_API
+ * \brief First word of the logs written by \ref OS_QueueRecordStart().
+ */
+#define OS_QUEUE_LOG_MAGIC      (0x4f53514cUL)
+
+/**
+ * \ingroup Queue_API
+ * \brief Format version of the logs written by \ref OS_QueueRecordStart().
+ */
+#define OS_QUEUE_LOG_VERSION    (1)
+
+/**
+ *  \class Header of the queue logs. The words are written in the byte order
+ *  of the recording host.
+ */
+typedef struct
+{
+    /** \ref OS_QUEUE_LOG_MAGIC */
+    uint32_t mul_Magic;
+    /** \ref OS_QUEUE_LOG_VERSION */
+    uint32_t mul_Version;
+}OS_queue_log_t;
+
+/**
+ *  \class Entry of the queue logs, which is followed by the 'mul_Size' bytes
+ *  of the message.
+ */
+typedef struct
+{
+    /** Time since boot the message was put at */
+    uint32_t mul_Seconds;
+    uint32_t mul_MicroSeconds;
+    /** Queue the message was put on */
+    uint32_t mul_QueueId;
+    /** Priority the message was put with */
+    uint32_t mul_Prio;
+    /** Size of the message */
+    uint32_t mul_Size;
+}OS_queue_log_entry_t;
+
+/**
+ * \ingroup Queue_API
+ * \brief Start recording the messages put on any queue of the process into
+ * a log file.
+ *
+ * Every message queued by \ref OS_QueuePut() and \ref OS_QueuePutTimed()
+ * appends an \ref OS_queue_log_entry_t and the message to 'pv_Buffer'.
+ * A background task writes the buffer to the file, so the
+ * putting tasks never wait for the disk. The messages not fitting in the
+ * buffer are not recorded and are counted as lost.
+ *
+ * The log can be injected back with the queue_replay sample.
+ *
+ * \param pc_Path      This is the path of the log file, which is truncated
+ * \param pv_Buffer    Memory buffering the log until it is written
+ * \param ul_BufferSize Size of 'pv_Buffer', of which the largest power of
+ *                     two is used
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error. OS_STATUS_EBUSY tells a recording
+ * is already running.
+ */
+int OS_QueueRecordStart (const char *pc_Path, void *pv_Buffer, uint32_t ul_BufferSize);
+
+/**
+ * \ingroup Queue_API
+ * \brief Stop recording the messages put, once the buffered ones are
+ * written to the log file.
+ *
+ * \param pul_Lost     Number of messages not recorded because the buffer
+ *                     was full, unless NULL
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error. OS_STATUS_EERR tells some of the
+ * log could not be written.
+ */
+int OS_QueueRecordStop (uint32_t *pul_Lost);
+
+#endif
+
 /**
  * \ingroup Queue_API
  * \brief Deletes the specified message queue.
@@ -120,17 +383,208 @@ int OS_QueueGet (
  * \param pv_Data        This is the pointer to the data to be sent
  * \param ul_Size        This is the size of the data
  * \param ul_Prio        This is the priority of the messages to be queued.
+ * Messages are retrieved by decreasing priority and in FIFO order within the
+ * same priority, see \ref OS_QUEUE_PRIO_LEVELS. On \ref OS_QUEUE_DEADLINE
+ * queues it is the relative deadline of the message in milliseconds.
  *
  * \return Upon successful the function returns '0' otherwise -1 is returned and
  * os_errno is set to indicate the error.
  */  
 int OS_QueuePut (uint32_t ul_QueueId, void *pv_Data, uint32_t ul_Size, uint32_t ul_Prio);
 
+/**
+ * \ingroup Queue_API
+ * \brief Put a message on a message queue, waiting for room while the queue
+ * is full.
+ *
+ * The producer sleeps until a consumer gives a message slot back, so it is
+ * throttled to the rate of the consumers instead of polling the queue. The
+ * \ref OS_QUEUE_OVERWRITE queues are never full and do not wait.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param pv_Data        This is the pointer to the data to be sent
+ * \param ul_Size        This is the size of the data
+ * \param ul_Prio        This is the priority of the message, as for
+ * \ref OS_QueuePut()
+ * \param l_Timeout This is the maximum time to wait for room, in
+ * milliseconds. When it is not positive the call waits as long as needed on
+ * the blocking queues and not at all on the OS_NONBLOCKING ones, as
+ * \ref OS_QueueGet() does.
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */  
+int OS_QueuePutTimed (
+        uint32_t ul_QueueId, 
+        void *pv_Data, 
+        uint32_t ul_Size, 
+        uint32_t ul_Prio, 
+        int32_t l_Timeout);
+
+/**
+ * \ingroup Queue_API
+ * \brief Put several messages with the same priority on a message queue in
+ * a single call.
+ *
+ * The messages are queued at once and the queue counting semaphore is
+ * increased by the number of messages stored. When the queue has not room
+ * for all of them, the first messages that fit are stored.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param ppv_Data      Array with the pointers to the data to be sent
+ * \param pul_Size      Array with the size of each of the data
+ * \param ul_Count      This is the number of messages to be sent
+ * \param ul_Prio       This is the priority of the messages to be queued
+ * \param pul_Put       This output parameter will store the number of
+ * messages actually queued
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_QueuePutMany (
+        uint32_t ul_QueueId,
+        void *ppv_Data[],
+        uint32_t pul_Size[],
+        uint32_t ul_Count,
+        uint32_t ul_Prio,
+        uint32_t *pul_Put);
+
+/**
+ * \ingroup Queue_API
+ * \brief Receive several messages from a message queue in a single call.
+ *
+ * The call pends or times out on the first message as \ref OS_QueueGet()
+ * does, and then retrieves without waiting the messages already queued, up to
+ * ul_Count.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param ppv_Data      Array with the buffers where the messages are copied
+ * \param ul_Size       This is the size of each of the buffers
+ * \param pul_SizeCopied Array storing the data size copied into each buffer
+ * \param ul_Count      This is the number of buffers
+ * \param pul_Got       This output parameter will store the number of
+ * messages received
+ * \param l_Timeout     This is the timeout
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_QueueGetMany (
+        uint32_t ul_QueueId,
+        void *ppv_Data[],
+        uint32_t ul_Size,
+        size_t pul_SizeCopied[],
+        uint32_t ul_Count,
+        uint32_t *pul_Got,
+        int32_t l_Timeout);
+
+/**
+ * \ingroup Queue_API
+ * \brief Reserve a free slot of a message queue so the message can be written
+ * in place, without the copy performed by \ref OS_QueuePut().
+ * 
+ * The slot shall be queued with \ref OS_QueueCommit() or given back with
+ * \ref OS_QueueRelease().
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param ppv_Data      This output parameter will point to the slot payload,
+ * which can hold up to the queue data size.
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */  
+int OS_QueueReserve (uint32_t ul_QueueId, void **ppv_Data);
+
+/**
+ * \ingroup Queue_API
+ * \brief Queue a slot previously obtained with \ref OS_QueueReserve().
+ * 
+ * A slot not reserved, or already committed, is rejected with
+ * OS_STATUS_EINVAL.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param pv_Data       This is the reserved slot payload
+ * \param ul_Size       This is the size of the data written in the slot
+ * \param ul_Prio       This is the priority of the message
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */  
+int OS_QueueCommit (uint32_t ul_QueueId, void *pv_Data, uint32_t ul_Size, uint32_t ul_Prio);
+
+/**
+ * \ingroup Queue_API
+ * \brief Receive a message on a message queue without copying it.
+ * 
+ * The message is read in place and its slot shall be given back with
+ * \ref OS_QueueRelease() once the message has been consumed. The call pends or
+ * times out as \ref OS_QueueGet() does.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param ppv_Data      This output parameter will point to the message payload
+ * \param pul_Size      This output parameter will store the message size
+ * \param l_Timeout     This is the timeout
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */  
+int OS_QueueBorrow (uint32_t ul_QueueId, void **ppv_Data, size_t *pul_Size, int32_t l_Timeout);
+
+/**
+ * \ingroup Queue_API
+ * \brief Give back to the queue a slot obtained with \ref OS_QueueBorrow(),
+ * or a reserved slot that will not be committed.
+ * 
+ * A slot released twice, or still queued, is rejected with
+ * OS_STATUS_EINVAL.
+ *
+ * \param ul_QueueId    This is the queue identifier
+ * \param pv_Data       This is the slot payload
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */  
+int OS_QueueRelease (uint32_t ul_QueueId, void *pv_Data);
+
+/**
+ * \ingroup Queue_API
+ * \brief Wait until any queue of a set holds messages.
+ *
+ * The call blocks until at least one of the queues holds a message or the
+ * timeout expires, and reports which queues hold messages. No message is
+ * retrieved, so a queue reported ready may be emptied by another consumer
+ * before the caller gets from it.
+ *
+ * \param pul_QueueIds  Array with the identifiers of the queues to wait for
+ * \param ul_Count      This is the number of queues in pul_QueueIds
+ * \param pul_Ready     Array of at least ul_Count entries where the
+ * identifiers of the queues holding messages are stored
+ * \param pul_NReady    This output parameter will store the number of
+ * entries stored in pul_Ready
+ * \param l_Timeout     This is the timeout in milliseconds. When it is not
+ * positive the call waits as long as needed, or only checks the queues when
+ * all of them are OS_NONBLOCKING, as \ref OS_QueueGet() does.
+ *
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_QueueSelect (
+        uint32_t pul_QueueIds[],
+        uint32_t ul_Count,
+        uint32_t pul_Ready[],
+        uint32_t *pul_NReady,
+        int32_t l_Timeout);
+
 /**
  * \ingroup Queue_API
  * \brief This function will pass back a pointer to structure that contains 
  all of the relevant info (name and creator) about the specified queue. 
  * 
+ * The info includes the queue telemetry: current and peak depth, queued,
+ * retrieved and dropped messages, and a histogram of the time the messages
+ * waited in the queue. The counters are always on and updated without
+ * taking any lock.
+ *
  * \param ul_QueueId        This is the queue identifier
  * \param pt_QueueProp      This is the pointer to the queue information
  *
@@ -223,6 +223,21 @@ int OS_CountSemDelete (uint32_t ul_SemId);
  */
 int OS_CountSemGive (uint32_t ul_SemId);
 
+/**
+ * \ingroup Count_Sem_API
+ * The function unlocks 'ul_Count' times the semaphore referenced by ul_SemId,
+ * as 'ul_Count' consecutive calls to \ref OS_CountSemGive() would do.
+ * 
+ * \param ul_SemId	The sem identifier returned in the semaphore creation.
+ * \param ul_Count	Number of units the semaphore value is increased.
+ * 
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ * 
+ * @see OS_CountSemGive
+ */
+int OS_CountSemGiveMany (uint32_t ul_SemId, uint32_t ul_Count);
+
 /**
  * \ingroup Count_Sem_API
  * The locks the semaphore referenced by ul_SemId by performing a
@@ -261,6 +276,21 @@ int OS_CountSemTimedWait (uint32_t ul_SemId, uint32_t ul_Msecs);
  */
 int OS_CountSemTryTake (uint32_t ul_SemId);
 
+/**
+ * \ingroup Count_Sem_API
+ * The function takes without waiting up to 'ul_Count' units of the semaphore
+ * referenced by ul_SemId.
+ * 
+ * \param ul_SemId	The sem identifier returned in the semaphore creation.
+ * \param ul_Count	Maximum number of units to take.
+ * \param pul_Taken	This output parameter stores the number of units taken,
+ * which may be zero.
+ * 
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_CountSemTryTakeMany (uint32_t ul_SemId, uint32_t ul_Count, uint32_t *pul_Taken);
+
 /**
  * \ingroup Count_Sem_API
  * This function will pass back a pointer to structure that contains
@@ -275,6 +305,52 @@ int OS_CountSemTryTake (uint32_t ul_SemId);
  */
 int OS_CountSemGetInfo (uint32_t ul_SemId, OS_count_sem_prop_t *pt_CountProp);
 
+#if defined(CONFIG_LINUX)
+
+#include <semaphore.h>
+
+/**
+ * \ingroup Count_Sem_API
+ * Size of the storage of a counting semaphore shared by several processes.
+ */
+#define OS_COUNT_SEM_SHARED_SIZE    sizeof(sem_t)
+
+/**
+ * \ingroup Count_Sem_API
+ * Creates a counting semaphore which other processes can use, placed in the
+ * 'pv_Storage' memory shared with them. They get their own identifier with
+ * \ref OS_CountSemAttachShared().
+ * 
+ * \param ul_SemId	this is the semaphore identifier assigned to the
+ * created count semaphore.
+ * \param pv_Storage	Shared memory of \ref OS_COUNT_SEM_SHARED_SIZE bytes
+ * holding the semaphore.
+ * \param ul_SemInitialValue	Initial value for the semaphore.
+ * 
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_CountSemCreateShared (
+        uint32_t *ul_SemId, 
+        void *pv_Storage, 
+        uint32_t ul_SemInitialValue);
+
+/**
+ * \ingroup Count_Sem_API
+ * Gives an identifier to the counting semaphore another process created in
+ * the 'pv_Storage' shared memory with \ref OS_CountSemCreateShared().
+ * Deleting the identifier leaves the semaphore to the other processes.
+ * 
+ * \param ul_SemId	this is the semaphore identifier assigned.
+ * \param pv_Storage	Shared memory holding the semaphore.
+ * 
+ * \return Upon successful the function returns '0' otherwise -1 is returned and
+ * os_errno is set to indicate the error.
+ */
+int OS_CountSemAttachShared (uint32_t *ul_SemId, void *pv_Storage);
+
+#endif
+
 
 #endif
 
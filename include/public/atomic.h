@@ -0,0 +1,162 @@
+/**
+ *  \file   atomic.h
+ *  \brief  Memory ordering helpers used by the lock-free OSAL objects
+ *
+ *  The helpers map to the GCC __atomic builtins when available. Older
+ *  compilers, as the ones used for the LEON targets, fall back to volatile
+ *  accesses plus the strongest barrier the compiler provides. Those targets
+ *  are uniprocessor and in-order, so a compiler barrier is enough there.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: atomic.h 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#ifndef _ATOMIC_H_
+#define _ATOMIC_H_
+
+/** Size of the cache line objects shared between tasks are aligned to */
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE     64
+#endif
+
+/** Places the member or variable at the start of its own cache line */
+#define CACHE_ALIGNED       __attribute__((aligned(CACHE_LINE_SIZE)))
+
+/** Prevents the compiler from moving memory accesses across this point */
+#define compiler_barrier()  __asm__ __volatile__("" : : : "memory")
+
+#if (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))
+
+#define atomic_load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define atomic_store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define atomic_mb()                 __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/*
+ * Stores 'v' in '*p' when it still holds 'old'. Returns non-zero on success.
+ */
+static inline int atomic_cas32(volatile uint32_t *p, uint32_t old, uint32_t v)
+{
+    return __atomic_compare_exchange_n(p, &old, v, 0, 
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Adds 'v' to '*p' and returns the new value.
+ */
+static inline uint32_t atomic_add32(volatile uint32_t *p, uint32_t v)
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_RELAXED);
+}
+
+/*
+ * Reads the 64-bit word '*p' in a single access, also on 32-bit hosts.
+ */
+static inline uint64_t atomic_load64(volatile uint64_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Stores 'v' in the 64-bit word '*p' when it still holds 'old'. Returns
+ * non-zero on success.
+ */
+static inline int atomic_cas64(volatile uint64_t *p, uint64_t old, uint64_t v)
+{
+    return __atomic_compare_exchange_n(p, &old, v, 0, 
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#else
+
+static inline uint32_t atomic_load_acquire(volatile uint32_t *p)
+{
+    uint32_t v = *p;
+    compiler_barrier();
+    return v;
+}
+
+static inline void atomic_store_release(volatile uint32_t *p, uint32_t v)
+{
+    compiler_barrier();
+    *p = v;
+}
+
+#if (__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)
+#define atomic_mb()                 __sync_synchronize()
+#else
+#define atomic_mb()                 compiler_barrier()
+#endif
+
+/*
+ * The old compilers do not provide a compare-and-swap for every target
+ * (SPARC V8 has none), so it runs with the interrupts disabled instead.
+ */
+static inline int atomic_cas32(volatile uint32_t *p, uint32_t old, uint32_t v)
+{
+    int32_t level;
+    int ret = 0;
+
+    level = OS_IntLock();
+    if (*p == old)
+    {
+        *p = v;
+        ret = 1;
+    }
+    OS_IntUnlock(level);
+
+    return ret;
+}
+
+static inline uint32_t atomic_add32(volatile uint32_t *p, uint32_t v)
+{
+    int32_t level;
+    uint32_t ret;
+
+    level = OS_IntLock();
+    ret = (*p += v);
+    OS_IntUnlock(level);
+
+    return ret;
+}
+
+static inline uint64_t atomic_load64(volatile uint64_t *p)
+{
+    int32_t level;
+    uint64_t ret;
+
+    level = OS_IntLock();
+    ret = *p;
+    OS_IntUnlock(level);
+
+    return ret;
+}
+
+static inline int atomic_cas64(volatile uint64_t *p, uint64_t old, uint64_t v)
+{
+    int32_t level;
+    int ret = 0;
+
+    level = OS_IntLock();
+    if (*p == old)
+    {
+        *p = v;
+        ret = 1;
+    }
+    OS_IntUnlock(level);
+
+    return ret;
+}
+
+#endif
+
+#endif /*_ATOMIC_H_*/
@@ -27,4 +27,33 @@
 										(uint32_t)GET_FIELD_BYTE( (buf), (off+2))<<16 |		\
 										(uint32_t)GET_FIELD_BYTE( (buf), (off+3))<<24   )
 
+/*
+ * Returns the index of the most significant bit set in 'x'. The value of 'x'
+ * shall not be zero.
+ */
+static inline uint32_t bit_fls32(uint32_t x)
+{
+#if (__GNUC__ > 3) || ((__GNUC__ == 3) && (__GNUC_MINOR__ >= 4))
+    return 31 - __builtin_clz(x);
+#else
+    uint32_t n = 0;
+
+    if (x & 0xffff0000) { n += 16; x >>= 16; }
+    if (x & 0x0000ff00) { n += 8;  x >>= 8;  }
+    if (x & 0x000000f0) { n += 4;  x >>= 4;  }
+    if (x & 0x0000000c) { n += 2;  x >>= 2;  }
+    if (x & 0x00000002) { n += 1; }
+    return n;
+#endif
+}
+
+/*
+ * Returns the index of the least significant bit set in 'x'. The value of 'x'
+ * shall not be zero.
+ */
+static inline uint32_t bit_ffs32(uint32_t x)
+{
+    return bit_fls32(x & (~x + 1));
+}
+
 #endif /*_BIT__UTIL_H_*/
@@ -219,6 +219,18 @@ static inline void list_splice(const struct s_list_head *list,
 		__list_splice(list, head);
 }
 
+/**
+ * list_splice_tail - join two lists, each list being a queue
+ * @list: the new list to add.
+ * @head: the place to add it in the first list.
+ */
+static inline void list_splice_tail(const struct s_list_head *list,
+				struct s_list_head *head)
+{
+	if (!list_empty(list))
+		__list_splice(list, head->prev);
+}
+
 /**
  * list_splice_init - join two lists and reinitialise the emptied list.
  * @list: the new list to add.
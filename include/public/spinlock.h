@@ -0,0 +1,82 @@
+/**
+ *  \file   spinlock.h
+ *  \brief  Lightweight lock protecting short critical sections of the OSAL
+ *  objects
+ *
+ *  On RTEMS the targets are uniprocessor, so the lock just disables the
+ *  interrupts and a task holding it can never be preempted by another one
+ *  spinning on it. Elsewhere it is a test-and-set lock which yields the
+ *  processor after spinning for a while.
+ *
+ *  The critical sections shall be short and shall not call any blocking
+ *  service.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: spinlock.h 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#ifndef _SPINLOCK_H_
+#define _SPINLOCK_H_
+
+#include <public/atomic.h>
+
+/** Number of attempts before the processor is yielded to other tasks */
+#define SPIN_LOCK_TRIES     100
+
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+static inline void spin_init(spinlock_t *l)
+{
+    l->locked = 0;
+}
+
+#if defined(CONFIG_RTEMS)
+
+#define spin_lock(l, level)     \
+    do { (void)(l); (level) = OS_IntLock(); } while(0)
+
+#define spin_unlock(l, level)   \
+    do { (void)(l); OS_IntUnlock(level); } while(0)
+
+#else
+
+static inline void __spin_lock(spinlock_t *l)
+{
+    int tries = 0;
+
+    while (l->locked || !atomic_cas32(&l->locked, 0, 1))
+    {
+        if (++tries == SPIN_LOCK_TRIES)
+        {
+            OS_TaskYield();
+            tries = 0;
+        }
+    }
+}
+
+static inline void __spin_unlock(spinlock_t *l)
+{
+    atomic_store_release(&l->locked, 0);
+}
+
+#define spin_lock(l, level)     \
+    do { (void)(level); __spin_lock(l); } while(0)
+
+#define spin_unlock(l, level)   \
+    do { (void)(level); __spin_unlock(l); } while(0)
+
+#endif
+
+#endif /*_SPINLOCK_H_*/
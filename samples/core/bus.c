@@ -0,0 +1,170 @@
+/**
+ *  \file   bus.c
+ *  \brief  This program publishes housekeeping and event messages on the
+ *  software bus. Two subscriber tasks receive the messages they subscribed
+ *  to, sharing the pool buffers of the publisher without copying them.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: bus.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSG_HK          1
+#define MSG_EVENT       2
+#define MSG_STOP        3
+
+#define MSG_MAX_SIZE    64
+#define POOL_BUFFERS    16
+#define QUEUE_DEPTH     8
+#define MESSAGES        10
+
+static uint8_t pool_memory[POOL_BUFFERS * OS_BUS_BUFFER_SIZE(MSG_MAX_SIZE)];
+
+static char hk_buffer[OS_QUEUE_BUFFER_SIZE(QUEUE_DEPTH, OS_BUS_MSG_SIZE)];
+static char all_buffer[OS_QUEUE_BUFFER_SIZE(QUEUE_DEPTH, OS_BUS_MSG_SIZE)];
+
+static uint32_t pool_id;
+static uint32_t hk_queue, all_queue;
+static uint32_t done;
+
+static void subscriber(void *param)
+{
+    uint32_t queue_id = *(uint32_t*)param;
+    uint32_t msg_id, size;
+    void *msg;
+
+    for(;;)
+    {
+        if( OS_BusReceive(queue_id, &msg, &msg_id, &size, 3000) < 0 )
+        {
+            printf("%s: ERROR (%d)\n", __func__, (int)os_errno);
+            break;
+        }
+
+        if( msg_id == MSG_STOP )
+        {
+            OS_BusRelease(msg);
+            break;
+        }
+
+        printf("Queue %d received message %d: %s\n", (int)queue_id,
+                (int)msg_id, (char*)msg);
+
+        /*  The buffer goes back to the pool with the last subscriber  */
+        OS_BusRelease(msg);
+    }
+
+    OS_CountSemGive(done);
+    OS_TaskExit();
+}
+
+static void publisher(void)
+{
+    OS_pool_prop_t prop;
+    uint32_t msg_id;
+    void *msg;
+    int i;
+
+    for( i = 0; i < MESSAGES; ++i )
+    {
+        if( OS_BusGetBuffer(pool_id, &msg) < 0 )
+        {
+            printf("%s: ERROR no buffer (%d)\n", __func__, (int)os_errno);
+            exit(1);
+        }
+
+        msg_id = (i % 3) ? MSG_HK : MSG_EVENT;
+        snprintf(msg, MSG_MAX_SIZE, "%s %d",
+                (msg_id == MSG_HK) ? "housekeeping" : "event", i);
+        if( OS_BusPublish(msg_id, msg, strlen(msg) + 1, 0) < 0 )
+            printf("%s: ERROR publishing (%d)\n", __func__, (int)os_errno);
+
+        OS_Sleep(100);
+    }
+
+    OS_BusGetBuffer(pool_id, &msg);
+    OS_BusPublish(MSG_STOP, msg, 0, 0);
+
+    OS_CountSemTake(done);
+    OS_CountSemTake(done);
+
+    /*  Every buffer is back once both subscribers released them    */
+    OS_PoolGetInfo(pool_id, &prop);
+    if( prop.mul_Allocated - prop.mul_Cached != 0 )
+    {
+        printf("%s: ERROR %d buffers not released\n", __func__,
+                (int)(prop.mul_Allocated - prop.mul_Cached));
+        exit(1);
+    }
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+    exit(0);
+}
+
+int main(void)
+{
+    uint32_t t1, t2, t3;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("===========\n");
+    printf("BUS EXAMPLE\n");
+    printf("===========\n");
+
+    ret = OS_PoolCreate(pool_memory, sizeof(pool_memory),
+            OS_BUS_BUFFER_SIZE(MSG_MAX_SIZE), &pool_id, 0);
+    ret |= OS_QueueCreate(&hk_queue, hk_buffer, sizeof(hk_buffer),
+            QUEUE_DEPTH, OS_BUS_MSG_SIZE, 0);
+    ret |= OS_QueueCreate(&all_queue, all_buffer, sizeof(all_buffer),
+            QUEUE_DEPTH, OS_BUS_MSG_SIZE, 0);
+    ret |= OS_CountSemCreate(&done, 0, 0);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the pool and the queues\n");
+        return -1;
+    }
+
+    /*  One queue takes the housekeeping, the other every message   */
+    ret = OS_BusSubscribe(MSG_HK, hk_queue);
+    ret |= OS_BusSubscribe(MSG_STOP, hk_queue);
+    ret |= OS_BusSubscribe(MSG_HK, all_queue);
+    ret |= OS_BusSubscribe(MSG_EVENT, all_queue);
+    ret |= OS_BusSubscribe(MSG_STOP, all_queue);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to subscribe the queues\n");
+        return -1;
+    }
+
+    ret = OS_TaskCreate (&t1,(void *)subscriber, 4096, 10, 0, (void*)&hk_queue);
+    ret |= OS_TaskCreate (&t2,(void *)subscriber, 4096, 10, 0, (void*)&all_queue);
+    ret |= OS_TaskCreate (&t3,(void *)publisher, 4096, 20, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
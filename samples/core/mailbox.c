@@ -0,0 +1,135 @@
+/**
+ *  \file   mailbox.c
+ *  \brief  This program creates a mailbox updated by a fast writer task and
+ *  sampled by a slower reader task, which always gets the latest complete
+ *  value and tells the new values from the ones already read.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: mailbox.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLES     10
+#define WRITES      100
+
+/*  Every field holds the same counter, a torn read would mix two of them  */
+typedef struct
+{
+    uint32_t counter;
+    uint32_t copy[7];
+}housekeeping_t;
+
+static char buffer[OS_MAILBOX_BUFFER_SIZE(sizeof(housekeeping_t))];
+
+static uint32_t id;
+
+static void writer(void)
+{
+    housekeeping_t hk;
+    uint32_t i, j;
+
+    for( i = 1; i <= WRITES; ++i )
+    {
+        hk.counter = i;
+        for( j = 0; j < 7; ++j )
+            hk.copy[j] = i;
+        OS_MailboxWrite(id, &hk, sizeof(hk));
+
+        OS_Sleep(5);
+    }
+
+    OS_TaskExit();
+}
+
+static void reader(void)
+{
+    housekeeping_t hk;
+    size_t size;
+    uint32_t writes, last = 0;
+    uint32_t i, j;
+    int32_t ret;
+
+    for( i = 0; i < SAMPLES; )
+    {
+        OS_Sleep(100);
+
+        ret = OS_MailboxRead(id, &hk, sizeof(hk), &size, &writes);
+        if( ret < 0 )
+        {
+            if( os_errno == OS_STATUS_QUEUE_EMPTY )
+                continue;
+            printf("%s: ERROR (%d)\n", __func__, (int)os_errno);
+            exit(1);
+        }
+
+        for( j = 0; j < 7; ++j )
+        {
+            if( hk.copy[j] != hk.counter )
+            {
+                printf("%s: ERROR torn value\n", __func__);
+                exit(1);
+            }
+        }
+
+        if( writes == last )
+            printf("Value %d, no new value\n", (int)hk.counter);
+        else
+            printf("Value %d, %d writes since the last read\n",
+                    (int)hk.counter, (int)(writes - last));
+        last = writes;
+        i++;
+    }
+
+    OS_MailboxDelete(id);
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+    exit(0);
+}
+
+int main(void)
+{
+    uint32_t t1, t2;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("===============\n");
+    printf("MAILBOX EXAMPLE\n");
+    printf("===============\n");
+
+    ret = OS_MailboxCreate(&id, buffer, sizeof(buffer), sizeof(housekeeping_t));
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the mailbox\n");
+        return -1;
+    }
+
+    ret = OS_TaskCreate (&t1,(void *)writer, 4096, 10, 0, (void*)NULL);
+    ret |= OS_TaskCreate (&t2,(void *)reader, 4096, 20, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
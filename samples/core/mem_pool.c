@@ -78,7 +78,7 @@ static void task(void *param)
     ASSERT( b );
 
     printf("Creating the pool...");
-    ret =  OS_PoolCreate((void*)pool, p.p_size, p.pb_size, &id);
+    ret =  OS_PoolCreate((void*)pool, p.p_size, p.pb_size, &id, 0);
     if( ret != 0 )
     {
         printf("\n(%d) : Cannot create pool\n", (int)ret);
@@ -0,0 +1,174 @@
+/**
+ *  \file   pool_free.c
+ *  \brief  This program takes buffers from a fixed pool, a growable pool
+ *  and a size class allocator and gives all of them back with
+ *  OS_FreeBuffer(), which finds their owner. Pointers not taken from any
+ *  of them are rejected.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: pool_free.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+#include <osal/osdebug.h>
+
+#include <stdio.h>
+
+#define POOL_SIZE           (4*1024)
+#define POOL_BUFFER_SIZE    64
+#define GROWABLE_SLAB       16
+#define GROWABLE_MAX        64
+#define CLASSES_SIZE        (24*1024)
+#define BUFFERS             32
+
+/*  The padding right after the pool memory is not part of any pool  */
+static struct
+{
+    uint8_t area[POOL_SIZE];
+    uint8_t past[POOL_BUFFER_SIZE];
+}pool;
+static uint8_t classes[CLASSES_SIZE];
+
+static const uint32_t class_sizes[] = { 32, 128, 512 };
+static const uint32_t class_buffers[] = { BUFFERS, BUFFERS, BUFFERS };
+
+static void *b[3 * BUFFERS];
+
+static void task(void *param)
+{
+    int32_t ret;
+    uint32_t pool_id, growable_id, classes_id;
+    uint32_t n = 0;
+    uint32_t i;
+    uint32_t local;
+
+    printf("Creating the pools...");
+    ret = OS_PoolCreate((void*)pool.area, sizeof(pool.area), POOL_BUFFER_SIZE, &pool_id, 0);
+    if( ret != 0 )
+    {
+        printf("\n(%d) : Cannot create the pool\n", (int)os_errno);
+        OS_TaskExit();
+    }
+    ret = OS_PoolCreateGrowable(POOL_BUFFER_SIZE, GROWABLE_SLAB, GROWABLE_MAX,
+            &growable_id, 0);
+    if( ret != 0 )
+    {
+        printf("\n(%d) : Cannot create the growable pool\n", (int)os_errno);
+        OS_PoolDelete(pool_id);
+        OS_TaskExit();
+    }
+    ret = OS_PoolCreateClasses((void*)classes, sizeof(classes), class_sizes,
+            class_buffers, sizeof(class_sizes) / sizeof(class_sizes[0]), &classes_id);
+    if( ret != 0 )
+    {
+        printf("\n(%d) : Cannot create the size classes\n", (int)os_errno);
+        OS_PoolDelete(growable_id);
+        OS_PoolDelete(pool_id);
+        OS_TaskExit();
+    }
+    printf("OK!!\n");
+
+    /*  The growable pool chains a slab every GROWABLE_SLAB buffers  */
+    for( i = 0; i < BUFFERS; ++i )
+    {
+        if( OS_GetPoolBuffer(pool_id, &b[n]) != 0 )
+            goto err;
+        n++;
+        if( OS_GetPoolBuffer(growable_id, &b[n]) != 0 )
+            goto err;
+        n++;
+        if( OS_PoolAlloc(classes_id, class_sizes[i % 3] - i, &b[n]) != 0 )
+            goto err;
+        n++;
+    }
+    printf("%d buffers taken\n", (int)n);
+
+    /*  Foreign pointers: none of them shall be taken as a buffer. Once one
+     *  is, the buffers the pools hold are unknown and none is given back */
+    ret = OS_FreeBuffer(&local);
+    ASSERT( ret != 0 );
+    if( ret == 0 )
+        goto err_report;
+    ret = OS_FreeBuffer(pool.past);
+    ASSERT( ret != 0 );
+    if( ret == 0 )
+        goto err_report;
+    ret = OS_ReturnPoolBuffer(growable_id, (uint8_t*)b[1] + 4);
+    ASSERT( ret != 0 );
+    if( ret == 0 )
+        goto err_report;
+    ret = OS_ReturnPoolBuffer(growable_id, b[0]);
+    ASSERT( ret != 0 );
+    if( ret == 0 )
+        goto err_report;
+    printf("Foreign pointers rejected\n");
+
+    /*  Every buffer goes back to its owner, whatever it is */
+    while( n > 0 )
+    {
+        ret = OS_FreeBuffer(b[--n]);
+        ASSERT( ret == 0 );
+        if( ret != 0 )
+            goto err;
+    }
+
+    /*  The owners are only deleted with all their buffers back */
+    if( (OS_PoolDeleteClasses(classes_id) != 0) ||
+            (OS_PoolDelete(growable_id) != 0) ||
+            (OS_PoolDelete(pool_id) != 0) )
+    {
+        printf("(%d) : Cannot delete the pools\n", (int)os_errno);
+        goto err_report;
+    }
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+
+    return;
+
+err:
+    while( n > 0 )
+        OS_FreeBuffer(b[--n]);
+    OS_PoolDeleteClasses(classes_id);
+    OS_PoolDelete(growable_id);
+    OS_PoolDelete(pool_id);
+err_report:
+    printf("============\n");
+    printf("TEST ERROR!!\n");
+    printf("============\n");
+}
+
+int main(void)
+{
+    uint32_t t1;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("============================\n");
+    printf("FREE ANY POOL BUFFER EXAMPLE\n");
+    printf("============================\n");
+
+    ret = OS_TaskCreate (&t1,(void *)task, 2048, 99, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
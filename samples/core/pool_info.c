@@ -0,0 +1,145 @@
+/**
+ *  \file   pool_info.c
+ *  \brief  This program follows the usage of a memory pool with
+ *  OS_PoolGetInfo(): buffers taken and returned, high-water mark, failures
+ *  and the buffers held by each task.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: pool_info.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+#include <osal/osdebug.h>
+
+#include <stdio.h>
+
+#define POOL_BUFFER_SIZE    64
+#define POOL_BUFFERS        16
+#define RETURNED            6
+
+static uint8_t pool[POOL_BUFFERS * POOL_BUFFER_SIZE];
+
+static void *b[POOL_BUFFERS];
+
+static void print_info(OS_pool_prop_t *prop)
+{
+    printf("  buffers %d, allocated %d (cached %d), peak %d\n",
+            (int)prop->mul_Buffers, (int)prop->mul_Allocated,
+            (int)prop->mul_Cached, (int)prop->mul_PeakAllocated);
+    printf("  allocs %d, frees %d, failures %d, %d allocs/s\n",
+            (int)prop->mul_Allocs, (int)prop->mul_Frees,
+            (int)prop->mul_Failures, (int)prop->mul_AllocRate);
+}
+
+static void task(void *param)
+{
+    OS_pool_prop_t prop;
+    int32_t ret;
+    uint32_t id;
+    uint32_t task_id;
+    void *aux;
+    int32_t i;
+
+    task_id = OS_TaskGetId();
+
+    printf("Creating the pool...");
+    ret = OS_PoolCreate((void*)pool, sizeof(pool), POOL_BUFFER_SIZE, &id,
+            OS_POOL_TRACK_OWNERS);
+    if( ret != 0 )
+    {
+        printf("\n(%d) : Cannot create pool\n", (int)os_errno);
+        OS_TaskExit();
+    }
+    printf("OK!!\n");
+
+    for( i = 0; i < POOL_BUFFERS; ++i )
+    {
+        ret = OS_GetPoolBuffer( id, &b[i] );
+        ASSERT( ret == 0 );
+        if( ret != 0 )
+            goto err;
+    }
+
+    /*  Exhausted, the failure is accounted  */
+    ret = OS_GetPoolBuffer( id, &aux );
+    ASSERT( ret != 0 );
+    if( ret == 0 )
+        goto err;
+
+    OS_PoolGetInfo(id, &prop);
+    printf("All the buffers taken:\n");
+    print_info(&prop);
+    if( (prop.mul_PeakAllocated != POOL_BUFFERS) || (prop.mul_Failures != 1) ||
+            (prop.mul_Held[task_id] != POOL_BUFFERS) )
+        goto err;
+
+    for( i = 0; i < RETURNED; ++i )
+    {
+        ret = OS_ReturnPoolBuffer( id, b[i] );
+        ASSERT( ret == 0 );
+        if( ret != 0 )
+            goto err;
+    }
+
+    /*  The high-water mark stays, the task holds the buffers left */
+    OS_PoolGetInfo(id, &prop);
+    printf("%d buffers returned:\n", RETURNED);
+    print_info(&prop);
+    if( (prop.mul_PeakAllocated != POOL_BUFFERS) ||
+            (prop.mul_Frees != RETURNED) ||
+            (prop.mul_Held[task_id] != POOL_BUFFERS - RETURNED) )
+        goto err;
+
+    for( ; i < POOL_BUFFERS; ++i )
+        OS_ReturnPoolBuffer( id, b[i] );
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+
+    OS_PoolDelete(id);
+
+    return;
+
+err:
+    for( ; i < POOL_BUFFERS; ++i )
+        OS_ReturnPoolBuffer( id, b[i] );
+    OS_PoolDelete(id);
+    printf("============\n");
+    printf("TEST ERROR!!\n");
+    printf("============\n");
+}
+
+int main(void)
+{
+    uint32_t t1;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("=================\n");
+    printf("POOL INFO EXAMPLE\n");
+    printf("=================\n");
+
+    ret = OS_TaskCreate (&t1,(void *)task, 2048, 99, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
@@ -0,0 +1,132 @@
+/**
+ *  \file   pool_magazine.c
+ *  \brief  This program shares a small pool between two tasks. The first
+ *  one takes and returns some buffers, which stay cached in its magazine,
+ *  then the second one takes every buffer of the pool, the cached ones
+ *  included.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: pool_magazine.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define POOL_BUFFERS        4
+#define POOL_BUFFER_SIZE    64
+#define CACHED              2
+
+static uint8_t pool[POOL_BUFFERS * POOL_BUFFER_SIZE];
+
+static uint32_t pool_id;
+static uint32_t semid;
+
+static void first(void)
+{
+    void *b[CACHED];
+    uint32_t i;
+
+    for( i = 0; i < CACHED; ++i )
+    {
+        if( OS_GetPoolBuffer(pool_id, &b[i]) != 0 )
+        {
+            printf("%s: ERROR (%d) taking buffer %d\n", __func__, (int)os_errno, (int)i);
+            exit(1);
+        }
+    }
+    printf("%s: %d buffers taken\n", __func__, CACHED);
+
+    /*  Kept in the magazine of the task, not given back to the pool   */
+    for( i = 0; i < CACHED; ++i )
+        OS_ReturnPoolBuffer(pool_id, b[i]);
+    printf("%s: %d buffers returned\n", __func__, CACHED);
+
+    OS_BinSemGive(semid);
+
+    OS_TaskExit();
+}
+
+static void second(void)
+{
+    void *b[POOL_BUFFERS];
+    uint32_t i;
+
+    OS_BinSemTake(semid);
+
+    /*  The last buffers are the ones cached by the other task  */
+    for( i = 0; i < POOL_BUFFERS; ++i )
+    {
+        if( OS_GetPoolBuffer(pool_id, &b[i]) != 0 )
+        {
+            printf("%s: ERROR (%d) taking buffer %d\n", __func__, (int)os_errno, (int)i);
+            printf("============\n");
+            printf("TEST ERROR!!\n");
+            printf("============\n");
+            exit(1);
+        }
+    }
+    printf("%s: %d buffers taken\n", __func__, POOL_BUFFERS);
+
+    for( i = 0; i < POOL_BUFFERS; ++i )
+        OS_ReturnPoolBuffer(pool_id, b[i]);
+
+    if( OS_PoolDelete(pool_id) != 0 )
+    {
+        printf("%s: ERROR (%d) deleting the pool\n", __func__, (int)os_errno);
+        exit(1);
+    }
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+    exit(0);
+}
+
+int main(void)
+{
+    uint32_t t1, t2;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("=====================\n");
+    printf("POOL MAGAZINE EXAMPLE\n");
+    printf("=====================\n");
+
+    ret = OS_PoolCreate((void*)pool, sizeof(pool), POOL_BUFFER_SIZE, &pool_id, 0);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the pool\n");
+        return -1;
+    }
+    if( OS_BinSemCreate(&semid, 0, 0) != 0 )
+    {
+        printf("ERR: unable to create the semaphore\n");
+        return -1;
+    }
+
+    ret = OS_TaskCreate (&t1,(void *)first, 4096, 10, 0, (void*)NULL);
+    ret |= OS_TaskCreate (&t2,(void *)second, 4096, 20, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
@@ -0,0 +1,149 @@
+/**
+ *  \file   queue_zero_copy.c
+ *  \brief  This program passes messages through a queue without copying
+ *  them, with OS_QueueReserve()/OS_QueueCommit() and
+ *  OS_QueueBorrow()/OS_QueueRelease(), in the default, SPSC and MPMC queue
+ *  modes. A slot committed or released twice, and a pointer that is not a
+ *  slot, are rejected.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: queue_zero_copy.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+#include <osal/osdebug.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define QUEUE_DEPTH     8
+#define MSG_SIZE        32
+
+static char buffer[OS_QUEUE_BUFFER_SIZE(QUEUE_DEPTH, MSG_SIZE)];
+
+static const uint32_t modes[] = { 0, OS_QUEUE_SPSC, OS_QUEUE_MPMC };
+static const char *mode_names[] = { "default", "SPSC", "MPMC" };
+
+/*  Runs the zero-copy calls on a queue created with 'flags', returns 0 when
+ *  every one behaves as expected   */
+static int test_mode(uint32_t flags)
+{
+    uint32_t id;
+    void *slot;
+    void *msg;
+    size_t size;
+    char foreign[MSG_SIZE];
+    int ret = -1;
+
+    if( OS_QueueCreate(&id, buffer, sizeof(buffer), QUEUE_DEPTH, MSG_SIZE,
+                flags | OS_NONBLOCKING) != 0 )
+    {
+        printf("(%d) : Cannot create the queue\n", (int)os_errno);
+        return -1;
+    }
+
+    /*  The message is written in place and queued once */
+    if( OS_QueueReserve(id, &slot) != 0 )
+        goto out;
+    strcpy(slot, "zero copy");
+    if( OS_QueueCommit(id, slot, strlen(slot) + 1, 0) != 0 )
+        goto out;
+    if( (OS_QueueCommit(id, slot, MSG_SIZE, 0) == 0) ||
+            (os_errno != OS_STATUS_EINVAL) )
+    {
+        printf("  slot committed twice\n");
+        goto out;
+    }
+
+    /*  The message is read in place and given back once    */
+    if( OS_QueueBorrow(id, &msg, &size, 0) != 0 )
+        goto out;
+    printf("  received %d bytes: %s\n", (int)size, (char*)msg);
+    if( OS_QueueRelease(id, msg) != 0 )
+        goto out;
+    if( (OS_QueueRelease(id, msg) == 0) || (os_errno != OS_STATUS_EINVAL) )
+    {
+        printf("  slot released twice\n");
+        goto out;
+    }
+
+    /*  Neither a slot not reserved nor a pointer out of the queue  */
+    if( (OS_QueueCommit(id, foreign, sizeof(foreign), 0) == 0) ||
+            (OS_QueueRelease(id, foreign) == 0) )
+    {
+        printf("  foreign pointer taken as a slot\n");
+        goto out;
+    }
+
+    /*  A reserved slot not committed is just given back    */
+    if( OS_QueueReserve(id, &slot) != 0 )
+        goto out;
+    if( OS_QueueRelease(id, slot) != 0 )
+        goto out;
+    if( OS_QueueCommit(id, slot, MSG_SIZE, 0) == 0 )
+    {
+        printf("  released slot committed\n");
+        goto out;
+    }
+
+    ret = 0;
+
+out:
+    OS_QueueDelete(id);
+    return ret;
+}
+
+static void task(void *param)
+{
+    uint32_t i;
+
+    for( i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i )
+    {
+        printf("%s queue\n", mode_names[i]);
+        if( test_mode(modes[i]) != 0 )
+        {
+            printf("============\n");
+            printf("TEST ERROR!!\n");
+            printf("============\n");
+            return;
+        }
+    }
+
+    printf("==============\n");
+    printf("TEST SUCCESS!!\n");
+    printf("==============\n");
+}
+
+int main(void)
+{
+    uint32_t t1;
+    int32_t ret;
+
+    OS_Init();
+
+    printf("=======================\n");
+    printf("ZERO-COPY QUEUE EXAMPLE\n");
+    printf("=======================\n");
+
+    ret = OS_TaskCreate (&t1,(void *)task, 4096, 99, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("ERR: unable to create the tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
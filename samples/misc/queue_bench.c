@@ -0,0 +1,170 @@
+/**
+ *  \file   queue_bench.c
+ *  \brief  This program measures the OS_QueuePut latency on a deep priority
+ *  queue and compares the priority bucket insertion with the former sorted
+ *  list insertion.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: queue_bench.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+#include <public/list.h>
+#include <public/bit_util.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEPTH       4096
+#define DATA_SIZE   16
+#define ROUNDS      8
+
+static char buffer[OS_QUEUE_BUFFER_SIZE(DEPTH, DATA_SIZE)];
+
+struct node
+{
+    struct s_list_head  list;
+    uint32_t            prio;
+};
+
+static struct node nodes[DEPTH];
+static uint32_t prios[DEPTH];
+
+static uint32_t bitmap;
+static struct s_list_head levels[OS_QUEUE_PRIO_LEVELS];
+
+static uint64_t now_usecs(void)
+{
+    OS_time_t t;
+
+    OS_GetTimeSinceBoot(&t);
+    return (uint64_t)t.mul_Seconds * 1000000 + t.mul_MicroSeconds;
+}
+
+/*  Insertion used by OS_QueuePut before the priority buckets   */
+static void sorted_insert(struct node *n, struct s_list_head *head)
+{
+    struct s_list_head *ptr;
+    struct node *entry;
+
+    list_for_each(ptr, head)
+    {
+        entry = list_entry(ptr, struct node, list);
+        if( entry->prio < n->prio )
+        {
+            list_add_tail(&n->list, ptr);
+            return;
+        }
+    }
+    list_add_tail(&n->list, head);
+}
+
+/*  Insertion used by OS_QueuePut with the priority buckets */
+static void bucket_insert(struct node *n)
+{
+    list_add_tail(&n->list, &levels[n->prio]);
+    bitmap |= (1UL << n->prio);
+}
+
+static void bench(void)
+{
+    struct s_list_head head;
+    uint64_t t0, sorted = 0, bucket = 0, put = 0, get = 0;
+    uint32_t id, i, r;
+    char data[DATA_SIZE];
+    size_t copied;
+
+    srand(1);
+    for( i = 0; i < DEPTH; ++i )
+        prios[i] = rand() % OS_QUEUE_PRIO_LEVELS;
+
+    if( OS_QueueCreate(&id, buffer, sizeof(buffer), DEPTH, DATA_SIZE,
+                OS_NONBLOCKING) < 0 )
+    {
+        printf("Error creating the queue (%d)\n", (int)os_errno);
+        OS_TaskExit();
+    }
+    memset(data, 0xa5, sizeof(data));
+
+    for( r = 0; r < ROUNDS; ++r )
+    {
+        INIT_LIST_HEAD(&head);
+        t0 = now_usecs();
+        for( i = 0; i < DEPTH; ++i )
+        {
+            nodes[i].prio = prios[i];
+            sorted_insert(&nodes[i], &head);
+        }
+        sorted += now_usecs() - t0;
+
+        bitmap = 0;
+        for( i = 0; i < OS_QUEUE_PRIO_LEVELS; ++i )
+            INIT_LIST_HEAD(&levels[i]);
+        t0 = now_usecs();
+        for( i = 0; i < DEPTH; ++i )
+            bucket_insert(&nodes[i]);
+        bucket += now_usecs() - t0;
+
+        t0 = now_usecs();
+        for( i = 0; i < DEPTH; ++i )
+        {
+            if( OS_QueuePut(id, data, sizeof(data), prios[i]) < 0 )
+            {
+                printf("Error putting message %d (%d)\n", (int)i, (int)os_errno);
+                OS_TaskExit();
+            }
+        }
+        put += now_usecs() - t0;
+
+        t0 = now_usecs();
+        for( i = 0; i < DEPTH; ++i )
+            OS_QueueGet(id, data, sizeof(data), &copied, 0);
+        get += now_usecs() - t0;
+    }
+
+    printf("Queue depth %d, %d rounds\n", DEPTH, ROUNDS);
+    printf("  sorted list insertion (before): %8.1f ns/msg\n",
+            (sorted * 1000.0) / (DEPTH * ROUNDS));
+    printf("  priority bucket insertion     : %8.1f ns/msg\n",
+            (bucket * 1000.0) / (DEPTH * ROUNDS));
+    printf("  OS_QueuePut                   : %8.1f ns/msg\n",
+            (put * 1000.0) / (DEPTH * ROUNDS));
+    printf("  OS_QueueGet                   : %8.1f ns/msg\n",
+            (get * 1000.0) / (DEPTH * ROUNDS));
+
+    OS_QueueDelete(id);
+    OS_TaskExit();
+}
+
+int main(void)
+{
+    uint32_t t1;
+    int32_t ret;
+
+	printf("Priority Queue Benchmark\n");
+
+    OS_Init();
+
+    ret = OS_TaskCreate (&t1,(void *)bench, 8192, 99, 0, (void*)NULL);
+    if( ret < 0 )
+    {
+        printf("Error creating tasks\n");
+        return -1;
+    }
+
+    OS_Start();
+
+    return 0;
+
+} /* end OS_Application Startup */
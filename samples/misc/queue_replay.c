@@ -0,0 +1,290 @@
+/**
+ *  \file   queue_replay.c
+ *  \brief  This program injects a queue log recorded with
+ *  OS_QueueRecordStart() back into queues and measures the throughput.
+ *
+ *  A queue is created for every queue found in the log and a task drains
+ *  each of them. The messages are put at the pace they were recorded or,
+ *  with '-f', as fast as the queues take them.
+ *
+ *      queue_replay [-f] [-d depth] log
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: queue_replay.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osapi.h>
+#include <public/atomic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEPTH       256
+
+struct replay_queue
+{
+    uint32_t            recorded_id;
+    uint32_t            id;
+    uint32_t            data_size;
+    uint32_t            put;
+    volatile uint32_t   got;
+};
+
+static struct replay_queue queues[OS_MAX_QUEUES];
+static uint32_t nqueues;
+
+static const char *log_path;
+static uint32_t depth = DEPTH;
+static int fast;
+
+static uint32_t messages;
+static uint64_t bytes;
+static uint32_t max_size;
+static uint64_t duration;
+
+static uint64_t now_usecs(void)
+{
+    OS_time_t t;
+
+    OS_GetTimeSinceBoot(&t);
+    return (uint64_t)t.mul_Seconds * 1000000 + t.mul_MicroSeconds;
+}
+
+static uint64_t entry_usecs(OS_queue_log_entry_t *entry)
+{
+    return (uint64_t)entry->mul_Seconds * 1000000 + entry->mul_MicroSeconds;
+}
+
+static struct replay_queue *find_queue(uint32_t recorded_id)
+{
+    uint32_t i;
+
+    for( i = 0; i < nqueues; ++i )
+    {
+        if( queues[i].recorded_id == recorded_id )
+            return &queues[i];
+    }
+
+    return NULL;
+}
+
+static FILE *open_log(void)
+{
+    OS_queue_log_t log;
+    FILE *f;
+
+    f = fopen(log_path, "rb");
+    if( f == NULL )
+    {
+        perror(log_path);
+        exit(1);
+    }
+
+    if( (fread(&log, sizeof(log), 1, f) != 1) ||
+            (log.mul_Magic != OS_QUEUE_LOG_MAGIC) ||
+            (log.mul_Version != OS_QUEUE_LOG_VERSION) )
+    {
+        printf("%s is not a queue log\n", log_path);
+        exit(1);
+    }
+
+    return f;
+}
+
+/*  Finds the queues of the log and the size of their messages  */
+static void scan_log(void)
+{
+    OS_queue_log_entry_t entry;
+    struct replay_queue *q;
+    uint64_t first = 0;
+    FILE *f;
+
+    f = open_log();
+    while( fread(&entry, sizeof(entry), 1, f) == 1 )
+    {
+        q = find_queue(entry.mul_QueueId);
+        if( q == NULL )
+        {
+            if( nqueues == OS_MAX_QUEUES )
+            {
+                printf("Too many queues in the log\n");
+                exit(1);
+            }
+            q = &queues[nqueues++];
+            q->recorded_id = entry.mul_QueueId;
+        }
+
+        if( entry.mul_Size > q->data_size )
+            q->data_size = entry.mul_Size;
+        if( entry.mul_Size > max_size )
+            max_size = entry.mul_Size;
+
+        if( messages++ == 0 )
+            first = entry_usecs(&entry);
+        duration = entry_usecs(&entry) - first;
+        bytes += entry.mul_Size;
+
+        if( fseek(f, entry.mul_Size, SEEK_CUR) < 0 )
+            break;
+    }
+    fclose(f);
+}
+
+static void drain(void *arg)
+{
+    struct replay_queue *q = (struct replay_queue*)arg;
+    uint8_t *data;
+    size_t copied;
+
+    data = malloc(q->data_size);
+    for(;;)
+    {
+        if( OS_QueueGet(q->id, data, q->data_size, &copied, 0) < 0 )
+        {
+            printf("Error getting a message (%d)\n", (int)os_errno);
+            OS_TaskExit();
+        }
+        atomic_add32(&q->got, 1);
+    }
+}
+
+static void replay(void)
+{
+    OS_queue_log_entry_t entry;
+    struct replay_queue *q;
+    uint64_t start, first = 0, due, now, lag = 0;
+    uint32_t i, put = 0;
+    uint8_t *data;
+    FILE *f;
+
+    data = malloc(max_size ? max_size : 1);
+    f = open_log();
+
+    start = now_usecs();
+    while( (fread(&entry, sizeof(entry), 1, f) == 1) &&
+            (fread(data, 1, entry.mul_Size, f) == entry.mul_Size) )
+    {
+        if( put == 0 )
+            first = entry_usecs(&entry);
+
+        if( !fast )
+        {
+            due = start + (entry_usecs(&entry) - first);
+            now = now_usecs();
+            if( now < due )
+                OS_uSleep(due - now);
+            else if( now - due > lag )
+                lag = now - due;
+        }
+
+        q = find_queue(entry.mul_QueueId);
+        if( OS_QueuePutTimed(q->id, data, entry.mul_Size, entry.mul_Prio, 0) < 0 )
+        {
+            printf("Error putting message %d (%d)\n", (int)put, (int)os_errno);
+            break;
+        }
+        q->put++;
+        put++;
+    }
+    fclose(f);
+
+    /*  Wait for the messages still queued  */
+    for( i = 0; i < nqueues; ++i )
+    {
+        while( queues[i].got != queues[i].put )
+            OS_uSleep(100);
+    }
+    now = now_usecs() - start;
+
+    printf("Replayed %u messages (%llu bytes) on %u queues %s\n",
+            (unsigned)put, (unsigned long long)bytes, (unsigned)nqueues,
+            fast ? "as fast as possible" : "at the recorded pace");
+    printf("  recorded duration : %10.3f ms\n", duration / 1000.0);
+    printf("  replay duration   : %10.3f ms\n", now / 1000.0);
+    if( now )
+        printf("  throughput        : %10.1f msg/s, %.1f MB/s\n",
+                put * 1000000.0 / now, bytes / (double)now);
+    if( !fast )
+        printf("  worst lag         : %10.3f ms\n", lag / 1000.0);
+
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t t, i;
+    int opt;
+    void *buffer;
+
+    while( (opt = getopt(argc, argv, "fd:")) != -1 )
+    {
+        switch( opt )
+        {
+            case 'f':
+                fast = 1;
+                break;
+            case 'd':
+                depth = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-f] [-d depth] log\n", argv[0]);
+                return 1;
+        }
+    }
+    if( (optind >= argc) || (depth == 0) )
+    {
+        printf("Usage: %s [-f] [-d depth] log\n", argv[0]);
+        return 1;
+    }
+    log_path = argv[optind];
+
+    OS_Init();
+
+    scan_log();
+    if( messages == 0 )
+    {
+        printf("%s holds no message\n", log_path);
+        return 1;
+    }
+
+    for( i = 0; i < nqueues; ++i )
+    {
+        buffer = malloc(OS_QUEUE_BUFFER_SIZE(depth, queues[i].data_size));
+        if( (buffer == NULL) ||
+                (OS_QueueCreate(&queues[i].id, buffer,
+                    OS_QUEUE_BUFFER_SIZE(depth, queues[i].data_size),
+                    depth, queues[i].data_size, 0) < 0) )
+        {
+            printf("Error creating the queue %d (%d)\n", (int)i, (int)os_errno);
+            return 1;
+        }
+
+        if( OS_TaskCreate(&t, (void*)drain, 8192, 98, 0, &queues[i]) < 0 )
+        {
+            printf("Error creating the task %d (%d)\n", (int)i, (int)os_errno);
+            return 1;
+        }
+    }
+
+    if( OS_TaskCreate(&t, (void*)replay, 8192, 99, 0, (void*)NULL) < 0 )
+    {
+        printf("Error creating the task (%d)\n", (int)os_errno);
+        return 1;
+    }
+
+    OS_Start();
+
+    return 0;
+}
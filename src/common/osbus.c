@@ -0,0 +1,383 @@
+/**
+ *  \file   osbus.c
+ *  \brief  This file implements the software bus
+ *
+ *  A message is written once in a buffer of a memory pool. Publishing it
+ *  puts a pointer to the buffer on every queue subscribed to its message ID,
+ *  so the message is never copied. The buffer holds a reference per
+ *  subscriber which received it, and it goes back to its pool with the last
+ *  \ref OS_BusRelease().
+ *
+ *  The subscribers of every message ID are found in a routing table, hashed
+ *  by message ID with open addressing. A message ID keeps its entry once
+ *  routed, so the lookup never meets deleted entries.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: osbus.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osdebug.h>
+#include <osal/osapi.h>
+#include <public/atomic.h>
+#include <public/spinlock.h>
+
+#include <stddef.h>
+
+#define _IS_BUS_INIT()   \
+{   \
+    if( !_bus_is_init ) \
+    { \
+        _os_bus_init(); \
+        _bus_is_init = 1; \
+    } \
+}
+#define _CHECK_BUS_INIT()  (_IS_BUS_INIT())
+
+/*  The bus buffers are taken from the memory pools */
+#ifdef CONFIG_OS_MEM_POOL_ENABLE
+
+#if (OS_MAX_BUS_ROUTES & (OS_MAX_BUS_ROUTES - 1)) != 0
+#error "OS_MAX_BUS_ROUTES shall be a power of two"
+#endif
+
+#define _BUS_ROUTE_MASK     (OS_MAX_BUS_ROUTES - 1)
+
+/** Header of the bus buffers, stored in front of the message   */
+struct os_bus_buffer
+{
+    uint32_t            pool_id;
+    volatile uint32_t   refs;
+    uint32_t            msg_id;
+    uint32_t            size;
+};
+
+typedef char _os_bus_buffer_size_check[
+    (sizeof(struct os_bus_buffer) == OS_BUS_BUFFER_OVERHEAD) ? 1 : -1];
+
+#define _BUS_BUFFER(buffer) \
+    ((struct os_bus_buffer*)((uint8_t*)(buffer) - OS_BUS_BUFFER_OVERHEAD))
+
+/** Queues subscribed to a message ID   */
+typedef struct
+{
+    uint32_t    used;
+    uint32_t    msg_id;
+    uint32_t    subscribers;
+    uint32_t    queue_id[OS_MAX_BUS_SUBSCRIBERS];
+}OS_bus_route_t;
+
+static uint8_t _bus_is_init = 0;
+
+/********************************* FILE PRIVATE VARIABLES  */
+
+LOCAL OS_bus_route_t os_bus_route[OS_MAX_BUS_ROUTES];
+
+/** Protects the routing table  */
+LOCAL spinlock_t os_bus_lock;
+
+/********************************* PRIVATE  INTERFACE    */
+
+static void _os_bus_init(void)
+{
+    int i;
+
+    for( i = 0; i < OS_MAX_BUS_ROUTES; ++i )
+    {
+        os_bus_route[i].used = FALSE;
+        os_bus_route[i].subscribers = 0;
+    }
+
+    spin_init(&os_bus_lock);
+
+    return;
+}
+
+static inline uint32_t _os_bus_hash(uint32_t msg_id)
+{
+    uint32_t h = msg_id * 0x9e3779b1UL;
+
+    return (h ^ (h >> 16)) & _BUS_ROUTE_MASK;
+}
+
+/* ===  FUNCTION  ======================================================================
+ *         Name:  _os_bus_route
+ *  Description:  Returns the route of the message ID, which is created if
+ *                'create' is TRUE and the message ID is not routed yet. Shall
+ *                be called with the bus lock held.
+ *   Parameters:  msg_id - message identifier
+ *                create - TRUE to create the route
+ *      Returns:  The route or NULL if not found or the table is full
+ * =====================================================================================
+ */
+static OS_bus_route_t *_os_bus_route(uint32_t msg_id, int create)
+{
+    uint32_t i, n;
+    OS_bus_route_t *route;
+
+    i = _os_bus_hash(msg_id);
+    for( n = 0; n < OS_MAX_BUS_ROUTES; ++n, i = (i + 1) & _BUS_ROUTE_MASK )
+    {
+        route = &os_bus_route[i];
+
+        if( route->used == FALSE )
+        {
+            if( !create )
+                return NULL;
+
+            route->used = TRUE;
+            route->msg_id = msg_id;
+            route->subscribers = 0;
+            return route;
+        }
+        if( route->msg_id == msg_id )
+            return route;
+    }
+
+    return NULL;
+}/* end _os_bus_route */
+
+/* ===  FUNCTION  ======================================================================
+ *         Name:  _os_bus_put
+ *  Description:  Drops a reference to a bus buffer and returns it to its
+ *                pool with the last one
+ *   Parameters:  hdr - header of the bus buffer
+ *      Returns:  0 on success, otherwise -1 and os_errno is set
+ * =====================================================================================
+ */
+static int _os_bus_put(struct os_bus_buffer *hdr)
+{
+    /*  The message reads of this reference shall be done before the buffer
+     *  can be reused   */
+    atomic_mb();
+    if( atomic_add32(&hdr->refs, (uint32_t)-1) != 0 )
+        return 0;
+    atomic_mb();
+
+    return OS_ReturnPoolBuffer(hdr->pool_id, hdr);
+}/* end _os_bus_put */
+
+/********************************* PUBLIC  INTERFACE    */
+
+int OS_BusSubscribe(uint32_t ul_MsgId, uint32_t ul_QueueId)
+{
+    OS_queue_prop_t prop;
+    OS_bus_route_t *route;
+    uint32_t level;
+    uint32_t i;
+    int status;
+
+    _CHECK_BUS_INIT();
+
+    /*  The queue shall take the buffer pointers the bus publishes   */
+    if( (OS_QueueGetInfo(ul_QueueId, &prop) < 0) || 
+            (prop.mul_DataSize < OS_BUS_MSG_SIZE) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    spin_lock(&os_bus_lock, level);
+    {
+        route = _os_bus_route(ul_MsgId, TRUE);
+        if( route == NULL )
+            status = OS_STATUS_NO_FREE_IDS;
+        else
+        {
+            status = 0;
+            for( i = 0; i < route->subscribers; ++i )
+            {
+                if( route->queue_id[i] == ul_QueueId )
+                    break;
+            }
+
+            if( i < route->subscribers )
+                status = OS_STATUS_EINVAL;
+            else if( route->subscribers >= OS_MAX_BUS_SUBSCRIBERS )
+                status = OS_STATUS_NO_FREE_IDS;
+            else
+                route->queue_id[route->subscribers++] = ul_QueueId;
+        }
+    }
+    spin_unlock(&os_bus_lock, level);
+
+    if( status )
+        os_return_minus_one_and_set_errno(status);
+
+    return 0;
+}/* end OS_BusSubscribe */
+
+int OS_BusUnsubscribe(uint32_t ul_MsgId, uint32_t ul_QueueId)
+{
+    OS_bus_route_t *route;
+    uint32_t level;
+    uint32_t i;
+    int status = OS_STATUS_EINVAL;
+
+    _CHECK_BUS_INIT();
+
+    spin_lock(&os_bus_lock, level);
+    {
+        route = _os_bus_route(ul_MsgId, FALSE);
+        for( i = 0; route != NULL && i < route->subscribers; ++i )
+        {
+            if( route->queue_id[i] == ul_QueueId )
+            {
+                /*  The delivery order of the subscribers does not matter */
+                route->queue_id[i] = route->queue_id[--route->subscribers];
+                status = 0;
+                break;
+            }
+        }
+    }
+    spin_unlock(&os_bus_lock, level);
+
+    if( status )
+        os_return_minus_one_and_set_errno(status);
+
+    return 0;
+}/* end OS_BusUnsubscribe */
+
+int OS_BusGetBuffer(uint32_t ul_PoolId, void **ppv_Buffer)
+{
+    struct os_bus_buffer *hdr;
+    void *buffer;
+
+    _CHECK_BUS_INIT();
+
+    ASSERT( ppv_Buffer != NULL );
+    if( ppv_Buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( OS_GetPoolBufferNoZero(ul_PoolId, &buffer) < 0 )
+        return -1;
+
+    hdr = (struct os_bus_buffer*)buffer;
+    hdr->pool_id = ul_PoolId;
+    hdr->refs = 1;
+    hdr->msg_id = 0;
+    hdr->size = 0;
+
+    *ppv_Buffer = hdr + 1;
+
+    return 0;
+}/* end OS_BusGetBuffer */
+
+int OS_BusPublish(uint32_t ul_MsgId, void *pv_Buffer, uint32_t ul_Size, uint32_t ul_Prio)
+{
+    uint32_t queue_id[OS_MAX_BUS_SUBSCRIBERS];
+    struct os_bus_buffer *hdr;
+    OS_bus_route_t *route;
+    uint32_t level;
+    uint32_t subscribers = 0;
+    uint32_t missed = 0;
+    uint32_t i;
+
+    _CHECK_BUS_INIT();
+
+    ASSERT( pv_Buffer != NULL );
+    if( pv_Buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    hdr = _BUS_BUFFER(pv_Buffer);
+
+    /*  Only a buffer owned by the caller can be published  */
+    if( hdr->refs != 1 )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    spin_lock(&os_bus_lock, level);
+    {
+        route = _os_bus_route(ul_MsgId, FALSE);
+        if( route != NULL )
+        {
+            subscribers = route->subscribers;
+            for( i = 0; i < subscribers; ++i )
+                queue_id[i] = route->queue_id[i];
+        }
+    }
+    spin_unlock(&os_bus_lock, level);
+
+    hdr->msg_id = ul_MsgId;
+    hdr->size = ul_Size;
+
+    /*  One reference per subscriber plus the one of the publisher, dropped
+     *  once every subscriber got the buffer    */
+    atomic_store_release(&hdr->refs, subscribers + 1);
+
+    for( i = 0; i < subscribers; ++i )
+    {
+        if( OS_QueuePut(queue_id[i], &pv_Buffer, OS_BUS_MSG_SIZE, ul_Prio) < 0 )
+        {
+            missed++;
+            _os_bus_put(hdr);
+        }
+    }
+
+    if( _os_bus_put(hdr) < 0 )
+        return -1;
+
+    if( missed )
+        os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+
+    return 0;
+}/* end OS_BusPublish */
+
+int OS_BusReceive(
+        uint32_t ul_QueueId,
+        void **ppv_Buffer,
+        uint32_t *pul_MsgId,
+        uint32_t *pul_Size,
+        int32_t l_Timeout)
+{
+    struct os_bus_buffer *hdr;
+    void *buffer;
+    size_t copied;
+
+    _CHECK_BUS_INIT();
+
+    ASSERT( ppv_Buffer != NULL );
+    if( ppv_Buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( OS_QueueGet(ul_QueueId, &buffer, OS_BUS_MSG_SIZE, &copied, l_Timeout) < 0 )
+        return -1;
+
+    if( copied != OS_BUS_MSG_SIZE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    hdr = _BUS_BUFFER(buffer);
+
+    *ppv_Buffer = buffer;
+    if( pul_MsgId != NULL )
+        *pul_MsgId = hdr->msg_id;
+    if( pul_Size != NULL )
+        *pul_Size = hdr->size;
+
+    return 0;
+}/* end OS_BusReceive */
+
+int OS_BusRelease(void *pv_Buffer)
+{
+    struct os_bus_buffer *hdr;
+
+    _CHECK_BUS_INIT();
+
+    ASSERT( pv_Buffer != NULL );
+    if( pv_Buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    hdr = _BUS_BUFFER(pv_Buffer);
+
+    if( hdr->refs == 0 )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    return _os_bus_put(hdr);
+}/* end OS_BusRelease */
+
+#endif
@@ -0,0 +1,242 @@
+/**
+ *  \file   osmailbox.c
+ *  \brief  This file implements the mailboxes
+ *
+ *  A mailbox is a sequence lock over two copies of the value. The sequence
+ *  counts twice the values written, plus one while a write is in progress.
+ *  Write 'n' goes to the copy 'n & 1', so the copy holding the latest value
+ *  is only overwritten once the next write completed and another one
+ *  started. A reader copies the latest value and just retries when that
+ *  happened meanwhile, a single write never disturbs it. The sequence wraps
+ *  around, so whether a value was ever written is kept in its own flag.
+ *
+ *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
+ *
+ *  \internal
+ *    Created:  10/17/2026
+ *   Revision:  $Id: osmailbox.c 1.4 10/17/2026 avs Exp $
+ *   Compiler:  gcc/g++
+ *    Company:  European Space Agency (ESA-ESTEC)
+ *  Copyright:  Copyright (c) 2026, Aitor Viana Sanchez
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ * =====================================================================================
+ */
+
+#include <osal/osdebug.h>
+#include <osal/osapi.h>
+#include <public/lock.h>
+#include <public/atomic.h>
+#include <public/spinlock.h>
+
+#include <string.h>
+
+#define INIT_THREAD_MUTEX() \
+    do{ \
+        int ret;    \
+        ret = lock_rw_init(&_rwlock);   \
+        ASSERT( ret >= 0 ); \
+        UNUSED(ret);    \
+    }while(0);
+
+
+#define WLOCK()   __WLOCK()
+#define WUNLOCK() __WUNLOCK()
+
+#define _IS_MAILBOX_INIT()   \
+{   \
+    if( !_mailbox_is_init ) \
+    { \
+        _os_mailbox_init(); \
+        _mailbox_is_init = 1; \
+    } \
+}
+#define _CHECK_MAILBOX_INIT()  (_IS_MAILBOX_INIT())
+
+static uint8_t _mailbox_is_init = 0;
+
+/********************************* FILE CLASSES/STRUCTURES */
+
+typedef struct
+{
+    /*  Serializes the writers  */
+    spinlock_t          lock CACHE_ALIGNED;
+    volatile uint32_t   seq;
+    /*  Set by the first write, never cleared   */
+    volatile uint32_t   written;
+    volatile uint32_t   size[2];
+    uint8_t             *copy[2];
+    uint32_t            data_size;
+    int                 free;
+}OS_mailbox_t;
+
+/********************************* FILE PRIVATE VARIABLES  */
+
+LOCAL OS_mailbox_t os_mailbox[OS_MAX_MAILBOXES];
+
+/********************************* PRIVATE  INTERFACE    */
+
+static void _os_mailbox_init(void)
+{
+    int i;
+
+    for( i = 0; i < OS_MAX_MAILBOXES; ++i )
+    {
+        os_mailbox[i].free = TRUE;
+        spin_init(&os_mailbox[i].lock);
+    }
+
+    INIT_THREAD_MUTEX();
+
+    return;
+}
+
+/********************************* PUBLIC  INTERFACE    */
+
+int OS_MailboxCreate(
+        uint32_t *pul_MailboxId,
+        void *pv_Buffer,
+        uint32_t ul_BufferSize,
+        uint32_t ul_DataSize)
+{
+    OS_mailbox_t *mailbox;
+    uint32_t possible_id;
+
+    _CHECK_MAILBOX_INIT();
+
+    /*  Sanity checks   */
+    if( (pul_MailboxId == NULL) || (pv_Buffer == NULL) || (ul_DataSize == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( ul_BufferSize < OS_MAILBOX_BUFFER_SIZE(ul_DataSize) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    WLOCK();
+    {
+        for( possible_id = 0; possible_id < OS_MAX_MAILBOXES; ++possible_id)
+        {
+            if( os_mailbox[possible_id].free == TRUE )
+                break;
+        }
+
+        if( possible_id >= OS_MAX_MAILBOXES )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        mailbox = &os_mailbox[possible_id];
+        mailbox->seq = 0;
+        mailbox->written = FALSE;
+        mailbox->size[0] = 0;
+        mailbox->size[1] = 0;
+        mailbox->copy[0] = (uint8_t*)pv_Buffer;
+        mailbox->copy[1] = (uint8_t*)pv_Buffer + OS_MAILBOX_BUFFER_SIZE(ul_DataSize) / 2;
+        mailbox->data_size = ul_DataSize;
+        mailbox->free = FALSE;
+    }
+    WUNLOCK();
+
+    *pul_MailboxId = possible_id;
+
+    return 0;
+}
+
+int OS_MailboxDelete(uint32_t ul_MailboxId)
+{
+    _CHECK_MAILBOX_INIT();
+
+    if( (ul_MailboxId >= OS_MAX_MAILBOXES) || os_mailbox[ul_MailboxId].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    WLOCK();
+    os_mailbox[ul_MailboxId].free = TRUE;
+    WUNLOCK();
+
+    return 0;
+}
+
+int OS_MailboxWrite(uint32_t ul_MailboxId, void *pv_Data, uint32_t ul_Size)
+{
+    OS_mailbox_t *mailbox;
+    uint32_t level;
+    uint32_t seq;
+    uint32_t i;
+
+    _CHECK_MAILBOX_INIT();
+
+    if( (ul_MailboxId >= OS_MAX_MAILBOXES) || os_mailbox[ul_MailboxId].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    mailbox = &os_mailbox[ul_MailboxId];
+
+    if( (pv_Data == NULL) || (ul_Size == 0) || (ul_Size > mailbox->data_size) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    spin_lock(&mailbox->lock, level);
+    {
+        seq = mailbox->seq;
+        i = (seq >> 1) & 1;
+
+        /*  Flag the write in progress before touching the copy */
+        mailbox->seq = seq + 1;
+        atomic_mb();
+
+        memcpy(mailbox->copy[i], pv_Data, ul_Size);
+        mailbox->size[i] = ul_Size;
+
+        atomic_store_release(&mailbox->seq, seq + 2);
+        if( mailbox->written == FALSE )
+            atomic_store_release(&mailbox->written, TRUE);
+    }
+    spin_unlock(&mailbox->lock, level);
+
+    return 0;
+}
+
+int OS_MailboxRead(
+        uint32_t ul_MailboxId,
+        void *pv_Data,
+        uint32_t ul_Size,
+        size_t *pul_SizeCopied,
+        uint32_t *pul_Writes)
+{
+    OS_mailbox_t *mailbox;
+    uint32_t seq, writes, size;
+    uint32_t i;
+
+    _CHECK_MAILBOX_INIT();
+
+    if( (ul_MailboxId >= OS_MAX_MAILBOXES) || os_mailbox[ul_MailboxId].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    mailbox = &os_mailbox[ul_MailboxId];
+
+    if( (pv_Data == NULL) || (pul_SizeCopied == NULL) || (ul_Size < mailbox->data_size) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( atomic_load_acquire(&mailbox->written) == FALSE )
+        os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_EMPTY);
+
+    for(;;)
+    {
+        seq = atomic_load_acquire(&mailbox->seq);
+        writes = seq >> 1;
+
+        /*  2^31 is even, the copy index survives the wrap around   */
+        i = (writes - 1) & 1;
+        size = mailbox->size[i];
+        memcpy(pv_Data, mailbox->copy[i], size);
+        atomic_mb();
+
+        /*  The copy is only reused by the write after the next one */
+        if( mailbox->seq - (seq & ~1UL) < 3 )
+            break;
+    }
+
+    *pul_SizeCopied = size;
+    if( pul_Writes != NULL )
+        *pul_Writes = writes;
+
+    return 0;
+}
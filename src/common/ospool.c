@@ -5,8 +5,43 @@
  *  The amount of static pool is given during the configuration of the OSAL
  *  layer. 
  *
- *  This implementation is common to all supported OSAL OSes and so it is not
- *  thread-safe. The thread-safe mechanisms shall be provided at user level.
+ *  This implementation is common to all supported OSAL OSes. The pools are
+ *  protected by the module lock, which most calls do not take: every task
+ *  caches a magazine of up to OS_POOL_MAGAZINE_SIZE buffers of each pool,
+ *  refilled from and flushed to the pool a batch at a time. A batch is half
+ *  a magazine, and no more than an eighth of the pool, so the buffers
+ *  cached leave some for the other tasks. A task finding both its magazine
+ *  and the pool empty takes the buffers cached by the other tasks, with the
+ *  lock held. A magazine is marked busy while its task uses it and the
+ *  other tasks skip it then.
+ *
+ *  The OS_POOL_LOCKFREE pools take no lock nor magazine at all, their free
+ *  list is updated with compare-and-swap, see struct s_lf_pool.
+ *
+ *  The OS_POOL_ZERO_ON_FREE pools keep the buffers returned in a list apart
+ *  until OS_PoolScrub() clears them, so the free list only holds cleared
+ *  buffers. They do not use the magazines either, a magazine would hand the
+ *  buffers returned out again before they are cleared.
+ *
+ *  The growable pools are a list of slabs taken from the heap as the pool
+ *  runs out of buffers. The slabs are aligned to their size, so the slab a
+ *  buffer belongs to is found masking its address, and then looked up in
+ *  the address index, as the memory there may not be a slab at all. Only
+ *  when the index is too small to hold every slab it is looked up in the
+ *  slab lists of the pool, with the lock held. A slab
+ *  with all its buffers back is released once it stays so
+ *  OS_POOL_SLAB_HYSTERESIS milliseconds, the first one is kept.
+ *
+ *  OS_FreeBuffer() finds the owner of a buffer in the address index, a hash
+ *  table of the address granules covered by the memory of every pool. The
+ *  index is rebuilt with the lock held when a pool or a slab comes or goes,
+ *  in the copy the readers do not use, so they never take the lock.
+ *
+ *  The accounting of the pools, see OS_PoolGetInfo(), is kept where the
+ *  buffers go: the magazines count the buffers they hand out and take back,
+ *  the pool the rest. The rates are worked out from samples of the counters
+ *  on creation and as the lock is taken, OS_POOL_RATE_WINDOW /
+ *  _POOL_RATE_SAMPLES milliseconds apart at least.
  *
  *  \author  Aitor Viana Sanchez (avs), Aitor.Viana.Sanchez@esa.int
  *
@@ -25,7 +60,17 @@
 
 #include <osal/osdebug.h>
 #include <osal/osapi.h>
+#include <osal/osstats.h>
 #include <public/lock.h>
+#include <public/atomic.h>
+#include <public/list.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CONFIG_LINUX)
+#include <sys/mman.h>
+#endif
 
 #include "pool.h"
 
@@ -74,144 +119,1845 @@ static void  _os_pool_init(void)
 
 /********************************* FILE CLASSES/STRUCTURES */
 
+/*  Samples of the counters of a pool the rates are worked out from    */
+#define _POOL_RATE_SAMPLES      8
+
+typedef struct
+{
+    uint32_t msecs;
+    uint32_t gets;
+    uint32_t returns;
+}OS_pool_sample_t;
+
 /* pools */
 typedef struct
 {
     struct s_pool pool;
-    uint32_t allocated;
+    /*  Free list of the OS_POOL_LOCKFREE pools */
+    struct s_lf_pool lf_pool;
+    /*  Buffers out of the pool, the ones cached in the magazines included */
+    volatile uint32_t allocated;
+    /*  Buffers the magazines are refilled and flushed with    */
+    uint32_t batch;
+    uint32_t flags;
     uint32_t free;
+    /*  Buffers returned to an OS_POOL_ZERO_ON_FREE pool not cleared yet  */
+    void *dirty;
+    uint32_t dirty_count;
+    /*  Slabs of the growable pools, 'pool' only gives their buffer size  */
+    struct s_list_head avail;
+    struct s_list_head full;
+    uint32_t slab_size;
+    uint32_t slab_header;
+    uint32_t slab_buffers;
+    uint32_t slabs;
+    uint32_t max_slabs;
+    /*  Accounting, but the buffers handed out and taken back by the
+     *  magazines   */
+    volatile uint32_t peak;
+    volatile uint32_t gets;
+    volatile uint32_t returns;
+    volatile uint32_t failures;
+    OS_pool_sample_t sample[_POOL_RATE_SAMPLES];
+    uint32_t samples;
+    /*  Owners of the buffers of the OS_POOL_TRACK_OWNERS pools, the task
+     *  identifier plus one, and the buffers held by every task. The last
+     *  entry counts the ones held outside the OSAL tasks  */
+    uint16_t *tags;
+    volatile uint32_t held[OS_MAX_TASKS + 1];
+#if defined(CONFIG_LINUX)
+    /*  Memory mapped by OS_PoolCreateAuto(), unmapped with the pool   */
+    void *mapping;
+    size_t mapping_size;
+#endif
 }OS_pool_t;
 
+#if defined(CONFIG_LINUX)
+/*  Length the huge page mappings are rounded up to, the usual huge page
+ *  size. Other sizes make the mapping fall back to regular pages   */
+#define _POOL_HUGE_PAGE_SIZE    (2UL << 20)
+#endif
+
+#define _POOL_IS_LOCKFREE(id) \
+    (os_pool[(id)].flags & OS_POOL_LOCKFREE)
+
+#define _POOL_IS_ZERO_ON_FREE(id) \
+    (os_pool[(id)].flags & OS_POOL_ZERO_ON_FREE)
+
+#define _POOL_IS_TRACKED(id) \
+    (os_pool[(id)].flags & OS_POOL_TRACK_OWNERS)
+
+/*  Flag of the pools created by OS_PoolCreateGrowable()    */
+#define _POOL_GROWABLE          (0x100)
+
+#define _POOL_IS_GROWABLE(id) \
+    (os_pool[(id)].flags & _POOL_GROWABLE)
+
+/*
+ * Slab of a growable pool, the header of a memory block aligned to its size
+ * and followed by the buffers. The slabs with free buffers are in the
+ * 'avail' list of the pool, the ones with all their buffers back at its
+ * tail, and the others in the 'full' one.
+ */
+typedef struct
+{
+    struct s_pool pool;
+    struct s_list_head list;
+    /*  Time all the buffers of the slab were back, in milliseconds */
+    uint32_t idle_since;
+    /*  Owner tags of the buffers, after the header, OS_POOL_TRACK_OWNERS
+     *  pools only  */
+    uint16_t *tags;
+}OS_pool_slab_t;
+
+/*  Size of the slab headers holding 'tags' owner tags */
+#define _POOL_SLAB_HEADER(tags) \
+    ((sizeof(OS_pool_slab_t) + (tags) * sizeof(uint16_t) + CACHE_LINE_SIZE - 1) & \
+     ~(CACHE_LINE_SIZE - 1))
+
+#define _POOL_SLAB_OF(id, ptr) \
+    ((OS_pool_slab_t*)((unsigned long)(ptr) & ~(unsigned long)(os_pool[(id)].slab_size - 1)))
+
+/*  Entry of the address index, the granule 'granule' holds memory of the
+ *  pool or size class allocator 'owner'  */
+typedef struct
+{
+    unsigned long granule;
+    uint32_t owner;
+}OS_pool_index_t;
+
+#define _POOL_INDEX_MASK        (OS_POOL_INDEX_SIZE - 1)
+
+/*  Smallest granule of the address index, 4 KB */
+#define _POOL_INDEX_MIN_SHIFT   12
+
+/*  Owners of the index entries, zero flags the free entries. The entries
+ *  of the slabs of the growable pools hold the slab address instead of a
+ *  granule   */
+#define _POOL_OWNER_POOL(id)    ((id) + 1)
+#define _POOL_OWNER_CLASSES(id) (OS_MAX_POOLS + (id) + 1)
+#define _POOL_OWNER_SLAB(id)    (OS_MAX_POOLS + OS_MAX_POOL_CLASS_SETS + (id) + 1)
+
+typedef char _os_pool_index_size_check[(OS_POOL_INDEX_SIZE & _POOL_INDEX_MASK) ? -1 : 1];
+
+/*  Buffers OS_PoolScrub() clears each time it takes the lock   */
+#define _POOL_SCRUB_BATCH       8
+
+/*  Entries of the class lookup tables  */
+#define _POOL_CLASS_LOOKUP      256
+
+/*
+ * Size class allocators. A request of 'size' bytes falls in the lookup entry
+ * '(size - 1) >> shift', which holds the smallest class fitting the
+ * smallest size of the entry. The next classes are only checked when
+ * several of them share an entry.
+ */
+typedef struct
+{
+    struct s_lf_pool pool[OS_MAX_POOL_CLASSES];
+    uint32_t classes;
+    uint32_t shift;
+    uint32_t max_size;
+    uint8_t lookup[_POOL_CLASS_LOOKUP];
+    uint32_t free;
+}OS_pool_classes_t;
+
+typedef char _os_pool_class_lookup_check[(OS_MAX_POOL_CLASSES <= 256) ? 1 : -1];
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+/*  Buffers of a pool cached by a task, only used by the task itself    */
+typedef struct
+{
+    /*  Set while the task uses the magazine, the other tasks skip it then */
+    volatile uint32_t busy;
+    uint32_t count;
+    /*  Buffers handed out and taken back by the magazine   */
+    uint32_t gets;
+    uint32_t returns;
+    void *buffer[OS_POOL_MAGAZINE_SIZE];
+}OS_pool_magazine_t;
+
+#define _POOL_MAGAZINE_BATCH    ((OS_POOL_MAGAZINE_SIZE + 1) / 2)
+/*  A batch takes no more than this fraction of the buffers of the pool  */
+#define _POOL_MAGAZINE_SHARE    8
+#endif
+
 /********************************* FILE PRIVATE VARIABLES  */
 
 LOCAL OS_pool_t os_pool[OS_MAX_POOLS];
 
-/********************************* PUBLIC  INTERFACE    */
+LOCAL OS_pool_classes_t os_pool_classes[OS_MAX_POOL_CLASS_SETS];
 
-static void  _os_pool_init(void)
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+LOCAL OS_pool_magazine_t os_pool_magazine[OS_MAX_TASKS][OS_MAX_POOLS];
+#endif
+
+/*  Two copies of the address index. Twice the rebuilds, plus one while a
+ *  rebuild is in progress, rebuild 'n' fills the copy 'n & 1'  */
+LOCAL OS_pool_index_t os_pool_index[2][OS_POOL_INDEX_SIZE];
+LOCAL uint32_t os_pool_index_shift[2];
+/*  Set when the entries did not fit in the copy    */
+LOCAL uint32_t os_pool_index_full[2];
+LOCAL volatile uint32_t os_pool_index_seq;
+
+static void _os_pool_index_rebuild(void);
+static int _os_pool_index_slab(uint32_t id, void *slab);
+static int _os_pool_slab_listed(uint32_t id, void *slab);
+
+/********************************* PRIVATE  INTERFACE    */
+
+/*  Identifier of the calling task, negative outside the OSAL tasks. Unlike
+ *  OS_TaskGetId() it leaves os_errno untouched, as the pool calls succeed
+ *  from any thread */
+static int _os_pool_task_id(void)
+{
+    int err = os_errno;
+    int task_id = OS_TaskGetId();
+
+    if( task_id < 0 )
+        os_errno = err;
+
+    return task_id;
+}
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+/*  Magazine of the pool for the calling task, NULL outside the OSAL tasks  */
+static inline OS_pool_magazine_t *_os_pool_magazine(uint32_t id)
+{
+    int task_id = _os_pool_task_id();
+
+    if( (task_id < 0) || (task_id >= OS_MAX_TASKS) )
+        return NULL;
+
+    return &os_pool_magazine[task_id][id];
+}
+
+/*  Buffers of the pool cached in the magazines. Shall be called with the
+ *  lock held  */
+static uint32_t _os_pool_cached(uint32_t id)
 {
+    uint32_t cached = 0;
     int i;
 
-    for( i = 0; i < OS_MAX_POOLS; ++i )
+    for( i = 0; i < OS_MAX_TASKS; ++i )
+        cached += os_pool_magazine[i][id].count;
+
+    return cached;
+}
+
+/*
+ * Moves up to 'n' buffers of the pool cached in the magazines of the other
+ * tasks to 'buffer', 'self' is the magazine of the caller if any. The
+ * magazines busy are skipped. Returns the number of buffers moved. Shall be
+ * called with the lock held.
+ */
+static uint32_t _os_pool_steal(uint32_t id, OS_pool_magazine_t *self, 
+        void *buffer[], uint32_t n)
+{
+    OS_pool_magazine_t *magazine;
+    uint32_t stolen = 0;
+    int i;
+
+    for( i = 0; (i < OS_MAX_TASKS) && (stolen < n); ++i )
     {
-        os_pool[i].free = TRUE;
-        os_pool[i].allocated = 0;
-        pool_init(&os_pool[i].pool);
+        magazine = &os_pool_magazine[i][id];
+        if( (magazine == self) || (magazine->count == 0) )
+            continue;
+        if( !atomic_cas32(&magazine->busy, 0, 1) )
+            continue;
+
+        while( (magazine->count > 0) && (stolen < n) )
+            buffer[stolen++] = magazine->buffer[--magazine->count];
+
+        atomic_store_release(&magazine->busy, 0);
     }
 
-    INIT_THREAD_MUTEX();
+    return stolen;
+}
+#endif
 
-    return;
+/*  Buffers the magazines of a pool of 'buffers' are refilled with  */
+static uint32_t _os_pool_batch(uint32_t buffers)
+{
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    buffers /= _POOL_MAGAZINE_SHARE;
+    if( buffers > _POOL_MAGAZINE_BATCH )
+        return _POOL_MAGAZINE_BATCH;
+
+    return (buffers > 0) ? buffers : 1;
+#else
+    return 0;
+#endif
 }
 
-int OS_PoolCreate(void *address, uint32_t size, uint32_t buffer_size, uint32_t *id)
+/*  Time since boot in milliseconds, it only stamps the idle slabs  */
+static uint32_t _os_pool_msecs(void)
 {
-    uint32_t possible_id;
+    OS_time_t t;
 
-    ASSERT(address);
-    ASSERT(id);
+    OS_GetTimeSinceBoot(&t);
+    return t.mul_Seconds * 1000 + t.mul_MicroSeconds / 1000;
+}
 
-    _CHECK_POOL_INIT();
+/*  Takes a new slab for the growable pool. Shall be called with the lock
+ *  held  */
+static OS_pool_slab_t *_os_pool_slab_alloc(uint32_t id)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
+    void *mem;
 
-    /*  Sanity checks   */
-    if( (address == NULL) || (id == NULL) )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-    if( (size == 0) || (buffer_size == 0) )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( pool->slabs >= pool->max_slabs )
+        return NULL;
+    if( posix_memalign(&mem, pool->slab_size, pool->slab_size) != 0 )
+        return NULL;
 
-    WLOCK();
+    slab = (OS_pool_slab_t*)mem;
+    if( _POOL_IS_ZERO_ON_FREE(id) )
+        pool_clear((uint8_t*)mem + pool->slab_header, pool->slab_size - pool->slab_header);
+    pool_init_memory( &slab->pool, (uint8_t*)mem + pool->slab_header, 
+            pool->slab_size - pool->slab_header, pool->pool.data_size );
+    slab->idle_since = 0;
+    slab->tags = NULL;
+    if( _POOL_IS_TRACKED(id) )
     {
-        for( possible_id = 0; possible_id < OS_MAX_POOLS; ++possible_id)
+        slab->tags = (uint16_t*)(slab + 1);
+        pool_clear(slab->tags, pool->slab_buffers * sizeof(uint16_t));
+    }
+
+    list_add(&slab->list, &pool->avail);
+    pool->slabs++;
+
+    _os_pool_index_rebuild();
+
+    return slab;
+}
+
+/*  Releases the slabs idle for OS_POOL_SLAB_HYSTERESIS milliseconds, the
+ *  last one is kept. Shall be called with the lock held  */
+static void _os_pool_slab_release(uint32_t id, uint32_t now)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
+    struct s_list_head *pos, *prev;
+    int released = 0;
+
+    /*  The idle slabs are the last ones of the list    */
+    for( pos = pool->avail.prev; pos != &pool->avail; pos = prev )
+    {
+        prev = pos->prev;
+        slab = list_entry(pos, OS_pool_slab_t, list);
+        if( pool_num_free_elements(&slab->pool) != pool->slab_buffers )
+            break;
+        if( pool->slabs == 1 )
+            break;
+        if( now - slab->idle_since < OS_POOL_SLAB_HYSTERESIS )
+            continue;
+
+        list_del(&slab->list);
+        pool->slabs--;
+        free(slab);
+        released = 1;
+    }
+
+    if( released )
+        _os_pool_index_rebuild();
+}
+
+/*
+ * Takes up to 'n' buffers from the free list of the pool, growing the
+ * growable pools when needed. Returns the number of buffers taken. Shall be
+ * called with the lock held.
+ */
+static uint32_t _os_pool_take(uint32_t id, void *buffer[], uint32_t n)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
+    uint32_t taken = 0;
+
+    if( !_POOL_IS_GROWABLE(id) )
+        return pool_alloc_nelem( &pool->pool, buffer, n );
+
+    while( taken < n )
+    {
+        if( list_empty(&pool->avail) )
         {
-            if( os_pool[possible_id].free == TRUE )
+            if( _os_pool_slab_alloc(id) == NULL )
                 break;
         }
 
-        /*  Check to see if the id is out of bounds */
-        if( possible_id >= OS_MAX_POOLS || os_pool[possible_id].free != TRUE)
+        slab = list_first_entry(&pool->avail, OS_pool_slab_t, list);
+        taken += pool_alloc_nelem( &slab->pool, buffer + taken, n - taken );
+        if( pool_num_free_elements(&slab->pool) == 0 )
+            list_move(&slab->list, &pool->full);
+    }
+
+    return taken;
+}
+
+/*  Gives 'n' buffers back to the free list of the pool. Shall be called
+ *  with the lock held  */
+static void _os_pool_give(uint32_t id, void *buffer[], uint32_t n)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
+    uint32_t now = 0;
+    int stamped = 0;
+    uint32_t i;
+
+    if( !_POOL_IS_GROWABLE(id) )
+    {
+        pool_free_nelem( &pool->pool, buffer, n );
+        return;
+    }
+
+    for( i = 0; i < n; ++i )
+    {
+        slab = _POOL_SLAB_OF(id, buffer[i]);
+        if( pool_num_free_elements(&slab->pool) == 0 )
+            list_move(&slab->list, &pool->avail);
+
+        pool_free_elem( &slab->pool, buffer[i] );
+
+        /*  The slabs in use are taken first, the idle ones may go  */
+        if( pool_num_free_elements(&slab->pool) == pool->slab_buffers )
         {
-            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+            if( !stamped++ )
+                now = _os_pool_msecs();
+            slab->idle_since = now;
+            list_move_tail(&slab->list, &pool->avail);
         }
+    }
 
-        /*  Set the possible id to allocated    */
-        os_pool[possible_id].free = FALSE;
+    /*  The clock is only read while there are idle slabs to release */
+    if( (pool->slabs > 1) && !list_empty(&pool->avail) )
+    {
+        slab = list_last_entry(&pool->avail, OS_pool_slab_t, list);
+        if( pool_num_free_elements(&slab->pool) == pool->slab_buffers )
+        {
+            if( !stamped )
+                now = _os_pool_msecs();
+            _os_pool_slab_release(id, now);
+        }
+    }
+}
+
+/*  Tells whether the free list of the pool has buffers or can grow. Shall be
+ *  called with the lock held  */
+static int _os_pool_has_free(uint32_t id)
+{
+    OS_pool_t *pool = &os_pool[id];
+
+    if( !_POOL_IS_GROWABLE(id) )
+        return pool_num_free_elements(&pool->pool) != 0;
+
+    return !list_empty(&pool->avail) || (pool->slabs < pool->max_slabs);
+}
+
+/*  Whether 'slab' is in the slab lists of the growable pool 'id'   */
+static int _os_pool_slab_listed(uint32_t id, void *slab)
+{
+    OS_pool_slab_t *entry;
+    int found = 0;
+
+    WLOCK();
+    {
+        list_for_each_entry(entry, &os_pool[id].avail, list)
+            found |= ((void*)entry == slab);
+        list_for_each_entry(entry, &os_pool[id].full, list)
+            found |= ((void*)entry == slab);
     }
     WUNLOCK();
 
-    /*  Create the partition    */
-    pool_init_memory( &os_pool[possible_id].pool, (uint8_t*)address, size, buffer_size);
+    return found;
+}
 
+/*  Tells whether 'buffer' belongs to the pool  */
+static int _os_pool_owns(uint32_t id, void *buffer)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
+    uint8_t *area;
+    int found;
 
-    /*  Set the poll id to the possible_id  */
-    *id = possible_id;
+    /*  The slab header is not read, the slab may not exist   */
+    if( _POOL_IS_GROWABLE(id) )
+    {
+        slab = _POOL_SLAB_OF(id, buffer);
+        area = (uint8_t*)slab + pool->slab_header;
+        return ((uint8_t*)buffer >= area) && 
+            ((uint8_t*)buffer < area + pool->slab_buffers * pool->pool.data_size) &&
+            (((uint8_t*)buffer - area) % pool->pool.data_size == 0) &&
+            ((found = _os_pool_index_slab(id, slab)) >= 0 ? found : 
+             _os_pool_slab_listed(id, slab));
+    }
 
-    return 0;
+    if( _POOL_IS_LOCKFREE(id) )
+        return ((uint8_t*)buffer >= pool->lf_pool.memory_area) &&
+            ((uint8_t*)buffer < pool->lf_pool.memory_area + pool->lf_pool.memory_area_size);
 
+    return pool_owns_elem(&pool->pool, buffer);
 }
 
-int OS_PoolDelete(uint32_t id)
+/*  Raises the peak of buffers out of the pool to 'allocated'   */
+static inline void _os_pool_peak(uint32_t id, uint32_t allocated)
 {
-    _CHECK_POOL_INIT();
+    uint32_t peak;
 
+    while( allocated > (peak = os_pool[id].peak) )
+    {
+        if( atomic_cas32(&os_pool[id].peak, peak, allocated) )
+            break;
+    }
+}
 
-    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+/*  Buffers handed out and taken back by the pool and its magazines   */
+static void _os_pool_totals(uint32_t id, uint32_t *gets, uint32_t *returns)
+{
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    int i;
+#endif
 
-    if( os_pool[id].allocated )
-        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    *gets = os_pool[id].gets;
+    *returns = os_pool[id].returns;
 
-    WLOCK();
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    for( i = 0; i < OS_MAX_TASKS; ++i )
     {
-        pool_init(&os_pool[id].pool);
-        os_pool[id].free = TRUE;
+        *gets += os_pool_magazine[i][id].gets;
+        *returns += os_pool_magazine[i][id].returns;
     }
-    WUNLOCK();
+#endif
+}
 
-    return 0;
+/*  Samples the counters of the pool unless the last sample is recent
+ *  enough. Shall be called with the lock held  */
+static void _os_pool_sample(uint32_t id, uint32_t now)
+{
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_sample_t *sample;
+
+    if( (pool->samples > 0) && 
+            (now - pool->sample[(pool->samples - 1) % _POOL_RATE_SAMPLES].msecs < 
+             OS_POOL_RATE_WINDOW / _POOL_RATE_SAMPLES) )
+        return;
 
+    sample = &pool->sample[pool->samples % _POOL_RATE_SAMPLES];
+    sample->msecs = now;
+    _os_pool_totals(id, &sample->gets, &sample->returns);
+    pool->samples++;
 }
 
-int OS_GetPoolBuffer(uint32_t id, void **buffer)
+/*  Owner tag of a buffer of an OS_POOL_TRACK_OWNERS pool   */
+static uint16_t *_os_pool_tag(uint32_t id, void *buffer)
 {
-    _CHECK_POOL_INIT();
+    OS_pool_t *pool = &os_pool[id];
+    OS_pool_slab_t *slab;
 
+    if( _POOL_IS_GROWABLE(id) )
+    {
+        slab = _POOL_SLAB_OF(id, buffer);
+        return &slab->tags[((uint8_t*)buffer - slab->pool.memory_area) / pool->pool.data_size];
+    }
 
-    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-    ASSERT( buffer != NULL );
-    if( buffer == NULL )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( _POOL_IS_LOCKFREE(id) )
+        return &pool->tags[((uint8_t*)buffer - pool->lf_pool.memory_area) / pool->lf_pool.data_size];
 
-    *buffer = pool_zalloc_elem( &os_pool[id].pool);
+    return &pool->tags[((uint8_t*)buffer - pool->pool.memory_area) / pool->pool.data_size];
+}
 
-    if( *buffer == NULL )
-        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+/*  Tags the buffer with the calling task   */
+static void _os_pool_tag_get(uint32_t id, void *buffer)
+{
+    int task_id = _os_pool_task_id();
 
-    CRITICAL( (os_pool[id].allocated++) );
+    if( (task_id < 0) || (task_id >= OS_MAX_TASKS) )
+        task_id = OS_MAX_TASKS;
 
-    return 0;
+    *_os_pool_tag(id, buffer) = task_id + 1;
+    atomic_add32(&os_pool[id].held[task_id], 1);
 }
 
-int OS_ReturnPoolBuffer(uint32_t id, void *buffer)
+/*  Clears the tag of the buffer given back */
+static void _os_pool_tag_return(uint32_t id, void *buffer)
 {
-    _CHECK_POOL_INIT();
+    uint16_t *tag = _os_pool_tag(id, buffer);
 
+    if( *tag != 0 )
+    {
+        atomic_add32(&os_pool[id].held[*tag - 1], (uint32_t)-1);
+        *tag = 0;
+    }
+}
 
-    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-    ASSERT( buffer != NULL );
-    if( buffer == NULL )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+/*  Resets the accounting of a pool being created. Shall be called with the
+ *  lock held  */
+static void _os_pool_account_init(uint32_t id)
+{
+    OS_pool_t *pool = &os_pool[id];
+    int i;
 
-    if( os_pool[id].allocated == 0 )
-        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    pool->peak = 0;
+    pool->gets = 0;
+    pool->returns = 0;
+    pool->failures = 0;
+    pool->samples = 0;
+    pool->tags = NULL;
+    for( i = 0; i <= OS_MAX_TASKS; ++i )
+        pool->held[i] = 0;
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    for( i = 0; i < OS_MAX_TASKS; ++i )
+    {
+        os_pool_magazine[i][id].gets = 0;
+        os_pool_magazine[i][id].returns = 0;
+    }
+#endif
 
-    pool_free_elem( &os_pool[id].pool, buffer );
+    /*  The first rates are measured from the creation  */
+    _os_pool_sample(id, _os_pool_msecs());
+}
 
-    CRITICAL( (os_pool[id].allocated--) );
+static inline uint32_t _os_pool_index_hash(unsigned long granule)
+{
+    uint32_t h = (uint32_t)(granule ^ (granule >> 16 >> 16)) * 0x9e3779b1UL;
 
-    return 0;
+    return (h ^ (h >> 16)) & _POOL_INDEX_MASK;
 }
 
-#endif
+/*  Adds the entry 'granule' of 'owner' to the index copy  */
+static void _os_pool_index_put(OS_pool_index_t *index, unsigned long granule, 
+        uint32_t owner)
+{
+    uint32_t i, n;
+
+    i = _os_pool_index_hash(granule);
+    for( n = 0; n < OS_POOL_INDEX_SIZE; ++n, i = (i + 1) & _POOL_INDEX_MASK )
+    {
+        if( index[i].owner == 0 )
+        {
+            index[i].granule = granule;
+            index[i].owner = owner;
+            return;
+        }
+    }
+}
+
+/* ===  FUNCTION  ======================================================================
+ *         Name:  _os_pool_index_add
+ *  Description:  Adds the granules of the memory [start, end) to the index,
+ *                or just counts them when 'index' is NULL
+ *   Parameters:  index, shift - index copy and its granule size
+ *                start, end - memory of the owner
+ *                owner - owner of the memory
+ *      Returns:  The number of granules of the memory
+ * =====================================================================================
+ */
+static uint32_t _os_pool_index_add(OS_pool_index_t *index, uint32_t shift, 
+        uint8_t *start, uint8_t *end, uint32_t owner)
+{
+    unsigned long granule, last;
+    uint32_t granules;
+
+    if( end <= start )
+        return 0;
+
+    granule = (unsigned long)start >> shift;
+    last = ((unsigned long)end - 1) >> shift;
+    granules = last - granule + 1;
+    if( index == NULL )
+        return granules;
+
+    for( ; granule <= last; ++granule )
+        _os_pool_index_put(index, granule, owner);
+
+    return granules;
+}
+
+/*  Adds the memory of a slab of the growable pool 'id' to the index, plus
+ *  the entry of the slab itself, or just counts them when 'index' is NULL */
+static uint32_t _os_pool_index_slab_add(OS_pool_index_t *index, uint32_t shift, 
+        uint32_t id, OS_pool_slab_t *slab)
+{
+    if( index != NULL )
+        _os_pool_index_put(index, (unsigned long)slab, _POOL_OWNER_SLAB(id));
+
+    return _os_pool_index_add(index, shift, (uint8_t*)slab, 
+            (uint8_t*)slab + os_pool[id].slab_size, _POOL_OWNER_POOL(id)) + 1;
+}
+
+/*  Adds the memory of all the pools and size class allocators to the index,
+ *  or just counts its granules when 'index' is NULL   */
+static uint32_t _os_pool_index_walk(OS_pool_index_t *index, uint32_t shift)
+{
+    OS_pool_t *pool;
+    OS_pool_slab_t *slab;
+    OS_pool_classes_t *set;
+    uint32_t i, granules = 0;
+
+    for( i = 0; i < OS_MAX_POOLS; ++i )
+    {
+        pool = &os_pool[i];
+        if( pool->free == TRUE )
+            continue;
+
+        if( _POOL_IS_GROWABLE(i) )
+        {
+            list_for_each_entry(slab, &pool->avail, list)
+                granules += _os_pool_index_slab_add(index, shift, i, slab);
+            list_for_each_entry(slab, &pool->full, list)
+                granules += _os_pool_index_slab_add(index, shift, i, slab);
+        }
+        else if( _POOL_IS_LOCKFREE(i) )
+            granules += _os_pool_index_add(index, shift, pool->lf_pool.memory_area, 
+                    pool->lf_pool.memory_area + pool->lf_pool.memory_area_size, 
+                    _POOL_OWNER_POOL(i));
+        else
+            granules += _os_pool_index_add(index, shift, pool->pool.memory_area, 
+                    pool->pool.memory_area + pool->pool.memory_area_size, 
+                    _POOL_OWNER_POOL(i));
+    }
+
+    for( i = 0; i < OS_MAX_POOL_CLASS_SETS; ++i )
+    {
+        set = &os_pool_classes[i];
+        if( set->free == TRUE )
+            continue;
+
+        granules += _os_pool_index_add(index, shift, set->pool[0].memory_area, 
+                set->pool[set->classes - 1].memory_area + 
+                set->pool[set->classes - 1].memory_area_size, 
+                _POOL_OWNER_CLASSES(i));
+    }
+
+    return granules;
+}
+
+/*  Rebuilds the address index, with the smallest granule keeping the index
+ *  half empty at most. Shall be called with the lock held  */
+static void _os_pool_index_rebuild(void)
+{
+    uint32_t seq = os_pool_index_seq;
+    uint32_t copy = (seq >> 1) & 1;
+    uint32_t shift = _POOL_INDEX_MIN_SHIFT;
+    uint32_t granules, i;
+
+    while( ((granules = _os_pool_index_walk(NULL, shift)) > OS_POOL_INDEX_SIZE / 2) &&
+            (shift < sizeof(unsigned long) * 8 - 1) )
+        shift++;
+
+    /*  Flag the rebuild in progress before touching the copy  */
+    os_pool_index_seq = seq + 1;
+    atomic_mb();
+
+    for( i = 0; i < OS_POOL_INDEX_SIZE; ++i )
+        os_pool_index[copy][i].owner = 0;
+    os_pool_index_shift[copy] = shift;
+    os_pool_index_full[copy] = (granules > OS_POOL_INDEX_SIZE);
+    _os_pool_index_walk(os_pool_index[copy], shift);
+
+    atomic_store_release(&os_pool_index_seq, seq + 2);
+}
 
+/*  Tells whether 'buffer' belongs to the size class allocator   */
+static int _os_pool_classes_owns(uint32_t id, void *buffer)
+{
+    OS_pool_classes_t *set = &os_pool_classes[id];
+
+    return ((uint8_t*)buffer >= set->pool[0].memory_area) &&
+        ((uint8_t*)buffer < set->pool[set->classes - 1].memory_area + 
+         set->pool[set->classes - 1].memory_area_size);
+}
+
+/*  Returns the owner of 'buffer' in the address index, zero when none   */
+static uint32_t _os_pool_index_find(void *buffer)
+{
+    OS_pool_index_t *index;
+    unsigned long granule;
+    uint32_t seq, owner, i, n;
+
+    for(;;)
+    {
+        seq = atomic_load_acquire(&os_pool_index_seq);
+        if( seq < 2 )
+            return 0;
+
+        index = os_pool_index[((seq >> 1) - 1) & 1];
+        granule = (unsigned long)buffer >> os_pool_index_shift[((seq >> 1) - 1) & 1];
+        owner = 0;
+
+        i = _os_pool_index_hash(granule);
+        for( n = 0; n < OS_POOL_INDEX_SIZE; ++n, i = (i + 1) & _POOL_INDEX_MASK )
+        {
+            if( index[i].owner == 0 )
+                break;
+            if( (index[i].granule != granule) || (index[i].owner >= _POOL_OWNER_SLAB(0)) )
+                continue;
+
+            /*  A granule may be shared by several owners   */
+            if( (index[i].owner <= OS_MAX_POOLS) ?
+                    _os_pool_owns(index[i].owner - 1, buffer) : 
+                    _os_pool_classes_owns(index[i].owner - OS_MAX_POOLS - 1, buffer) )
+            {
+                owner = index[i].owner;
+                break;
+            }
+        }
+        atomic_mb();
+
+        /*  The copy is only reused by the rebuild after the next one */
+        if( os_pool_index_seq - (seq & ~1UL) < 3 )
+            return owner;
+    }
+}
+
+/*  Whether 'slab' is a slab of the growable pool 'id' in the address index,
+ *  negative when the index is full and the slab may be missing */
+static int _os_pool_index_slab(uint32_t id, void *slab)
+{
+    OS_pool_index_t *index;
+    uint32_t seq, i, n;
+    int found;
+
+    for(;;)
+    {
+        seq = atomic_load_acquire(&os_pool_index_seq);
+        if( seq < 2 )
+            return 0;
+
+        index = os_pool_index[((seq >> 1) - 1) & 1];
+        found = os_pool_index_full[((seq >> 1) - 1) & 1] ? -1 : 0;
+
+        i = _os_pool_index_hash((unsigned long)slab);
+        for( n = 0; n < OS_POOL_INDEX_SIZE; ++n, i = (i + 1) & _POOL_INDEX_MASK )
+        {
+            if( index[i].owner == 0 )
+                break;
+            if( (index[i].granule == (unsigned long)slab) && 
+                    (index[i].owner == _POOL_OWNER_SLAB(id)) )
+            {
+                found = 1;
+                break;
+            }
+        }
+        atomic_mb();
+
+        /*  The copy is only reused by the rebuild after the next one */
+        if( os_pool_index_seq - (seq & ~1UL) < 3 )
+            return found;
+    }
+}
+
+/********************************* PUBLIC  INTERFACE    */
+
+static void  _os_pool_init(void)
+{
+    int i;
+
+    for( i = 0; i < OS_MAX_POOLS; ++i )
+    {
+        os_pool[i].free = TRUE;
+        os_pool[i].allocated = 0;
+        pool_init(&os_pool[i].pool);
+        INIT_LIST_HEAD(&os_pool[i].avail);
+        INIT_LIST_HEAD(&os_pool[i].full);
+    }
+
+    for( i = 0; i < OS_MAX_POOL_CLASS_SETS; ++i )
+        os_pool_classes[i].free = TRUE;
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    for( i = 0; i < OS_MAX_TASKS * OS_MAX_POOLS; ++i )
+    {
+        os_pool_magazine[i / OS_MAX_POOLS][i % OS_MAX_POOLS].busy = 0;
+        os_pool_magazine[i / OS_MAX_POOLS][i % OS_MAX_POOLS].count = 0;
+    }
+#endif
+
+    STATS_INIT_POOL();
+
+    INIT_THREAD_MUTEX();
+
+    return;
+}
+
+int OS_PoolCreate(
+        void *address, 
+        uint32_t size, 
+        uint32_t buffer_size, 
+        uint32_t *id, 
+        uint32_t flags)
+{
+    uint32_t possible_id;
+
+    ASSERT(address);
+    ASSERT(id);
+
+    _CHECK_POOL_INIT();
+
+    /*  Sanity checks   */
+    if( (address == NULL) || (id == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( (size == 0) || (buffer_size == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( flags & ~(OS_POOL_LOCKFREE | OS_POOL_ZERO_ON_FREE | OS_POOL_TRACK_OWNERS) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( (flags & OS_POOL_LOCKFREE) && (flags & OS_POOL_ZERO_ON_FREE) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    /*  The free list of these pools only holds cleared buffers    */
+    if( flags & OS_POOL_ZERO_ON_FREE )
+        pool_clear(address, size);
+
+    WLOCK();
+    {
+        for( possible_id = 0; possible_id < OS_MAX_POOLS; ++possible_id)
+        {
+            if( os_pool[possible_id].free == TRUE )
+                break;
+        }
+
+        /*  Check to see if the id is out of bounds */
+        if( possible_id >= OS_MAX_POOLS || os_pool[possible_id].free != TRUE)
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        /*  Create the partition    */
+        os_pool[possible_id].flags = flags;
+        os_pool[possible_id].dirty = NULL;
+        os_pool[possible_id].dirty_count = 0;
+#if defined(CONFIG_LINUX)
+        os_pool[possible_id].mapping = NULL;
+#endif
+        if( flags & OS_POOL_LOCKFREE )
+            lf_pool_init_memory( &os_pool[possible_id].lf_pool, (uint8_t*)address, size, buffer_size);
+        else
+            pool_init_memory( &os_pool[possible_id].pool, (uint8_t*)address, size, buffer_size);
+        os_pool[possible_id].batch = _os_pool_batch(os_pool[possible_id].pool.free_blocks);
+
+        _os_pool_account_init(possible_id);
+        if( flags & OS_POOL_TRACK_OWNERS )
+        {
+            os_pool[possible_id].tags = (uint16_t*)calloc( (flags & OS_POOL_LOCKFREE) ?
+                    os_pool[possible_id].lf_pool.num_elements : 
+                    os_pool[possible_id].pool.free_blocks, sizeof(uint16_t) );
+            if( os_pool[possible_id].tags == NULL )
+            {
+                os_pool[possible_id].flags = 0;
+                WUNLOCK();
+                os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+            }
+        }
+
+        /*  Set the possible id to allocated    */
+        os_pool[possible_id].free = FALSE;
+        _os_pool_index_rebuild();
+
+        STATS_CREAT_POOL();
+    }
+    WUNLOCK();
+
+
+    /*  Set the poll id to the possible_id  */
+    *id = possible_id;
+
+    return 0;
+
+}
+
+#if defined(CONFIG_LINUX)
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_PoolCreateAuto
+ *  Description:  Creates a pool of 'count' buffers in memory mapped by the
+ *  call, on huge pages when the system has them. The memory is prefaulted
+ *  and locked and the buffers start cache lines.
+ *  Parameters:
+ *      - count:        number of buffers
+ *      - buffer_size:  size of the buffers, rounded up to CACHE_LINE_SIZE
+ *      - id:           pool identifier returned
+ *      - flags:        OS_POOL_LOCKFREE, OS_POOL_TRACK_OWNERS or zero
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any parameter is not valid
+ *      OS_STATUS_NO_FREE_IDS when there is no free pool
+ *      OS_STATUS_EERR when the memory can not be mapped
+ * =====================================================================================
+ */
+int OS_PoolCreateAuto(uint32_t count, uint32_t buffer_size, uint32_t *id, uint32_t flags)
+{
+    uint64_t stride, size, length;
+    void *mapping;
+
+    _CHECK_POOL_INIT();
+
+    /*  Sanity checks   */
+    if( (id == NULL) || (count == 0) || (buffer_size == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    stride = ((uint64_t)buffer_size + CACHE_LINE_SIZE - 1) & ~(uint64_t)(CACHE_LINE_SIZE - 1);
+    size = stride * count;
+    if( size > 0xffffffffUL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    /*  Prefaulted by the mapping itself, regular pages when there are no
+     *  huge pages left */
+    mapping = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    length = (size + _POOL_HUGE_PAGE_SIZE - 1) & ~(uint64_t)(_POOL_HUGE_PAGE_SIZE - 1);
+    mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, 
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+#endif
+    if( mapping == MAP_FAILED )
+    {
+        length = size;
+        mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, 
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if( mapping == MAP_FAILED )
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    /*  Locking needs the privilege or a large enough RLIMIT_MEMLOCK, the
+     *  pages are resident anyway   */
+    mlock(mapping, length);
+
+    if( OS_PoolCreate(mapping, size, stride, id, flags) < 0 )
+    {
+        munmap(mapping, length);
+        return -1;
+    }
+
+    WLOCK();
+    {
+        os_pool[*id].mapping = mapping;
+        os_pool[*id].mapping_size = length;
+    }
+    WUNLOCK();
+
+    return 0;
+
+}/* end OS_PoolCreateAuto */
+#endif
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_PoolCreateGrowable
+ *  Description:  Creates a pool taking its memory from the heap a slab at a
+ *  time, as it runs out of buffers. The first slab is taken by the call.
+ *  Parameters:
+ *      - buffer_size:  size of the buffers
+ *      - slab_buffers: minimum number of buffers of a slab, the slab size is
+ *                      rounded up to a power of two
+ *      - max_buffers:  buffers the pool can grow to, rounded up to whole
+ *                      slabs
+ *      - id:           pool identifier returned
+ *      - flags:        OS_POOL_ZERO_ON_FREE, OS_POOL_TRACK_OWNERS or zero
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any parameter is not valid
+ *      OS_STATUS_NO_FREE_IDS when there is no free pool
+ *      OS_STATUS_EERR when the first slab can not be allocated
+ * =====================================================================================
+ */
+int OS_PoolCreateGrowable(
+        uint32_t buffer_size, 
+        uint32_t slab_buffers, 
+        uint32_t max_buffers, 
+        uint32_t *id, 
+        uint32_t flags)
+{
+    OS_pool_t *pool;
+    uint32_t possible_id, data_size, slab_size, header, buffers;
+    uint64_t need;
+
+    _CHECK_POOL_INIT();
+
+    /*  Sanity checks   */
+    if( (id == NULL) || (buffer_size == 0) || (slab_buffers == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( max_buffers < slab_buffers )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( flags & ~(OS_POOL_ZERO_ON_FREE | OS_POOL_TRACK_OWNERS) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    data_size = (buffer_size > MINIMUM_ELEMENT_SIZE) ? buffer_size : MINIMUM_ELEMENT_SIZE;
+    need = _POOL_SLAB_HEADER((flags & OS_POOL_TRACK_OWNERS) ? slab_buffers : 0) + 
+        (uint64_t)slab_buffers * data_size;
+    if( need > 0x80000000UL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    for( slab_size = CACHE_LINE_SIZE; slab_size < need; slab_size <<= 1 )
+        ;
+
+    /*  The header holds a tag for every buffer the slab may fit  */
+    header = _POOL_SLAB_HEADER(0);
+    if( flags & OS_POOL_TRACK_OWNERS )
+        header = _POOL_SLAB_HEADER((slab_size - header) / data_size);
+    buffers = (slab_size - header) / data_size;
+
+    WLOCK();
+    {
+        for( possible_id = 0; possible_id < OS_MAX_POOLS; ++possible_id)
+        {
+            if( os_pool[possible_id].free == TRUE )
+                break;
+        }
+
+        if( possible_id >= OS_MAX_POOLS )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        pool = &os_pool[possible_id];
+        pool_init(&pool->pool);
+        pool->pool.data_size = data_size;
+        pool->flags = flags | _POOL_GROWABLE;
+        pool->dirty = NULL;
+        pool->dirty_count = 0;
+#if defined(CONFIG_LINUX)
+        pool->mapping = NULL;
+#endif
+        pool->slab_size = slab_size;
+        pool->slab_header = header;
+        pool->slab_buffers = buffers;
+        pool->slabs = 0;
+        pool->max_slabs = (max_buffers + pool->slab_buffers - 1) / pool->slab_buffers;
+        pool->batch = _os_pool_batch(pool->max_slabs * pool->slab_buffers);
+        _os_pool_account_init(possible_id);
+
+        if( _os_pool_slab_alloc(possible_id) == NULL )
+        {
+            pool->flags = 0;
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        }
+
+        pool->free = FALSE;
+        _os_pool_index_rebuild();
+
+        STATS_CREAT_POOL();
+    }
+    WUNLOCK();
+
+    *id = possible_id;
+
+    return 0;
+
+}/* end OS_PoolCreateGrowable */
+
+int OS_PoolDelete(uint32_t id)
+{
+    OS_pool_slab_t *slab;
+    uint32_t cached = 0;
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    int i;
+#endif
+
+    _CHECK_POOL_INIT();
+
+
+    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    WLOCK();
+    {
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+        cached = _os_pool_cached(id);
+#endif
+        if( os_pool[id].allocated != cached )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+        }
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+        /*  The buffers cached belong to the pool memory, just forget them  */
+        for( i = 0; i < OS_MAX_TASKS; ++i )
+            os_pool_magazine[i][id].count = 0;
+#endif
+
+        if( _POOL_IS_GROWABLE(id) )
+        {
+            list_splice_init(&os_pool[id].full, &os_pool[id].avail);
+            while( !list_empty(&os_pool[id].avail) )
+            {
+                slab = list_first_entry(&os_pool[id].avail, OS_pool_slab_t, list);
+                list_del(&slab->list);
+                free(slab);
+            }
+            os_pool[id].slabs = 0;
+        }
+
+#if defined(CONFIG_LINUX)
+        if( os_pool[id].mapping != NULL )
+            munmap(os_pool[id].mapping, os_pool[id].mapping_size);
+        os_pool[id].mapping = NULL;
+#endif
+
+        if( os_pool[id].tags != NULL )
+            free(os_pool[id].tags);
+        os_pool[id].tags = NULL;
+
+        pool_init(&os_pool[id].pool);
+        os_pool[id].flags = 0;
+        os_pool[id].dirty = NULL;
+        os_pool[id].dirty_count = 0;
+        os_pool[id].allocated = 0;
+        os_pool[id].free = TRUE;
+        _os_pool_index_rebuild();
+
+        STATS_DEL_POOL();
+    }
+    WUNLOCK();
+
+    return 0;
+
+}
+
+/*
+ * Takes a buffer of an OS_POOL_ZERO_ON_FREE pool. The buffers not cleared
+ * yet are taken first when the caller does not need a cleared one, and only
+ * cleared here when no cleared one is left.
+ */
+static int _os_pool_get_zeroed(uint32_t id, void **buffer, int clear)
+{
+    OS_pool_t *pool = &os_pool[id];
+    void *ptr = NULL;
+    int dirty = 0;
+
+    WLOCK();
+    {
+        if( !clear || !_os_pool_has_free(id) )
+        {
+            ptr = pool->dirty;
+            if( ptr != NULL )
+            {
+                pool->dirty = POOL_NEXT_FREE(ptr);
+                pool->dirty_count--;
+                dirty = 1;
+            }
+        }
+        if( (ptr == NULL) && (_os_pool_take(id, &ptr, 1) == 0) )
+            ptr = NULL;
+        if( ptr != NULL )
+        {
+            pool->allocated++;
+            pool->gets++;
+            _os_pool_peak(id, pool->allocated);
+        }
+        _os_pool_sample(id, _os_pool_msecs());
+    }
+    WUNLOCK();
+
+    if( ptr == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    /*  The cleared buffers still hold the free list link   */
+    if( clear )
+        pool_clear(ptr, dirty ? pool->pool.data_size : sizeof(void*));
+
+    *buffer = ptr;
+
+    return 0;
+}
+
+static int _os_pool_get_buffer(uint32_t id, void **buffer, int clear)
+{
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    OS_pool_magazine_t *magazine;
+    uint32_t n;
+#endif
+
+    _CHECK_POOL_INIT();
+
+
+    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    ASSERT( buffer != NULL );
+    if( buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _POOL_IS_LOCKFREE(id) )
+    {
+        *buffer = lf_pool_alloc_elem( &os_pool[id].lf_pool );
+        if( *buffer == NULL )
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+        _os_pool_peak(id, atomic_add32(&os_pool[id].allocated, 1));
+        atomic_add32(&os_pool[id].gets, 1);
+        if( clear )
+            pool_clear(*buffer, os_pool[id].lf_pool.data_size);
+
+        return 0;
+    }
+
+    if( _POOL_IS_ZERO_ON_FREE(id) )
+        return _os_pool_get_zeroed(id, buffer, clear);
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    /*  A magazine busy is being emptied by another task, the pool is used
+     *  instead    */
+    magazine = _os_pool_magazine(id);
+    if( (magazine != NULL) && atomic_cas32(&magazine->busy, 0, 1) )
+    {
+        if( magazine->count == 0 )
+        {
+            WLOCK();
+            n = _os_pool_take( id, magazine->buffer, os_pool[id].batch );
+            os_pool[id].allocated += n;
+            _os_pool_peak(id, os_pool[id].allocated);
+            /*  Already out of the pool, 'allocated' stays  */
+            if( n == 0 )
+                n = _os_pool_steal( id, magazine, magazine->buffer, os_pool[id].batch );
+            _os_pool_sample(id, _os_pool_msecs());
+            WUNLOCK();
+
+            if( n == 0 )
+            {
+                atomic_store_release(&magazine->busy, 0);
+                os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+            }
+            magazine->count = n;
+        }
+
+        *buffer = magazine->buffer[--magazine->count];
+        magazine->gets++;
+        atomic_store_release(&magazine->busy, 0);
+        if( clear )
+            pool_clear(*buffer, os_pool[id].pool.data_size);
+
+        return 0;
+    }
+#endif
+
+    WLOCK();
+    {
+        if( _os_pool_take( id, buffer, 1 ) == 1 )
+        {
+            os_pool[id].allocated++;
+            os_pool[id].gets++;
+            _os_pool_peak(id, os_pool[id].allocated);
+        }
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+        else if( _os_pool_steal( id, NULL, buffer, 1 ) == 1 )
+            os_pool[id].gets++;
+#endif
+        else
+            *buffer = NULL;
+        _os_pool_sample(id, _os_pool_msecs());
+    }
+    WUNLOCK();
+
+    if( *buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    /*  Out of the lock, nobody else can reach the buffer   */
+    if( clear )
+        pool_clear(*buffer, os_pool[id].pool.data_size);
+
+    return 0;
+}
+
+/*  Counts the failures and tags the buffers taken  */
+static int _os_pool_get(uint32_t id, void **buffer, int clear)
+{
+    if( _os_pool_get_buffer(id, buffer, clear) < 0 )
+    {
+        if( os_errno == OS_STATUS_EERR )
+            atomic_add32(&os_pool[id].failures, 1);
+        return -1;
+    }
+
+    if( _POOL_IS_TRACKED(id) )
+        _os_pool_tag_get(id, *buffer);
+
+    return 0;
+}
+
+int OS_GetPoolBuffer(uint32_t id, void **buffer)
+{
+    return _os_pool_get(id, buffer, 1);
+}
+
+int OS_GetPoolBufferNoZero(uint32_t id, void **buffer)
+{
+    return _os_pool_get(id, buffer, 0);
+}
+
+int OS_ReturnPoolBuffer(uint32_t id, void *buffer)
+{
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    OS_pool_magazine_t *magazine;
+#endif
+
+    _CHECK_POOL_INIT();
+
+
+    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    ASSERT( buffer != NULL );
+    if( buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( os_pool[id].allocated == 0 )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    /*  Untagged before it is given back, taken again it is tagged anew  */
+    if( _POOL_IS_TRACKED(id) )
+    {
+        if( !_os_pool_owns(id, buffer) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        _os_pool_tag_return(id, buffer);
+    }
+
+    if( _POOL_IS_LOCKFREE(id) )
+    {
+        if( lf_pool_free_elem( &os_pool[id].lf_pool, buffer ) < 0 )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+        atomic_add32(&os_pool[id].allocated, (uint32_t)-1);
+        atomic_add32(&os_pool[id].returns, 1);
+
+        return 0;
+    }
+
+    /*  Checked before the buffer can reach the dirty list or a magazine,
+     *  where a foreign one would later be handed out   */
+    if( !_os_pool_owns(id, buffer) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _POOL_IS_ZERO_ON_FREE(id) )
+    {
+        WLOCK();
+        {
+            POOL_NEXT_FREE(buffer) = os_pool[id].dirty;
+            os_pool[id].dirty = buffer;
+            os_pool[id].dirty_count++;
+            os_pool[id].allocated--;
+            os_pool[id].returns++;
+            _os_pool_sample(id, _os_pool_msecs());
+        }
+        WUNLOCK();
+
+        return 0;
+    }
+
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+    magazine = _os_pool_magazine(id);
+    if( (magazine != NULL) && atomic_cas32(&magazine->busy, 0, 1) )
+    {
+        if( (magazine->count == OS_POOL_MAGAZINE_SIZE) || 
+                (magazine->count >= 2 * os_pool[id].batch) )
+        {
+            /*  Keep the most recently returned buffers, the cache warm ones */
+            WLOCK();
+            _os_pool_give( id, magazine->buffer, os_pool[id].batch );
+            os_pool[id].allocated -= os_pool[id].batch;
+            _os_pool_sample(id, _os_pool_msecs());
+            WUNLOCK();
+
+            magazine->count -= os_pool[id].batch;
+            memmove(magazine->buffer, magazine->buffer + os_pool[id].batch,
+                    magazine->count * sizeof(void*));
+        }
+
+        magazine->buffer[magazine->count++] = buffer;
+        magazine->returns++;
+        atomic_store_release(&magazine->busy, 0);
+
+        return 0;
+    }
+#endif
+
+    WLOCK();
+    {
+        _os_pool_give( id, &buffer, 1 );
+        os_pool[id].allocated--;
+        os_pool[id].returns++;
+        _os_pool_sample(id, _os_pool_msecs());
+    }
+    WUNLOCK();
+
+    return 0;
+}
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_PoolScrub
+ *  Description:  Clears the buffers returned to an OS_POOL_ZERO_ON_FREE pool
+ *  and gives them back to its free list. The lock is taken for
+ *  _POOL_SCRUB_BATCH buffers at a time.
+ *  Parameters:
+ *      - id:       pool identifier
+ *      - max:      maximum number of buffers to clear, zero for all of them
+ *      - cleared:  number of buffers cleared, may be NULL
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the pool is not an OS_POOL_ZERO_ON_FREE pool
+ * =====================================================================================
+ */
+int OS_PoolScrub(uint32_t id, uint32_t max, uint32_t *cleared)
+{
+    OS_pool_t *pool;
+    uint32_t n, count = 0;
+    void *ptr;
+
+    _CHECK_POOL_INIT();
+
+    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( !_POOL_IS_ZERO_ON_FREE(id) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    pool = &os_pool[id];
+
+    do
+    {
+        WLOCK();
+        for( n = 0; (n < _POOL_SCRUB_BATCH) && (pool->dirty != NULL); ++n )
+        {
+            if( (max != 0) && (count == max) )
+                break;
+
+            ptr = pool->dirty;
+            pool->dirty = POOL_NEXT_FREE(ptr);
+            pool->dirty_count--;
+
+            pool_clear(ptr, pool->pool.data_size);
+            _os_pool_give( id, &ptr, 1 );
+            count++;
+        }
+        WUNLOCK();
+    }while( n == _POOL_SCRUB_BATCH );
+
+    if( cleared != NULL )
+        *cleared = count;
+
+    return 0;
+
+}/* end OS_PoolScrub */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  _os_pool_classes_setup
+ *  Description:  Lays out the classes one after the other in the memory and
+ *                fills the lookup table of the allocator
+ *   Parameters:  set - allocator
+ *                address, size - memory of the allocator
+ *                class_size, class_buffers, classes - buffer sizes and
+ *                number of buffers of the classes
+ *      Returns:  0 on success, otherwise -1 and os_errno is set
+ * =====================================================================================
+ */
+static int _os_pool_classes_setup(OS_pool_classes_t *set, uint8_t *address, 
+        uint32_t size, const uint32_t class_size[], 
+        const uint32_t class_buffers[], uint32_t classes)
+{
+    uint32_t offset = 0;
+    uint32_t data_size, part;
+    uint32_t c, i;
+
+    for( c = 0; c < classes; ++c )
+    {
+        if( (class_size[c] == 0) || (class_buffers[c] == 0) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( (c > 0) && (class_size[c] <= class_size[c - 1]) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+        /*  Each class starts 8 bytes aligned after the previous one   */
+        data_size = (class_size[c] + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+        if( class_buffers[c] > (size - offset) / data_size )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        part = class_buffers[c] * data_size;
+
+        lf_pool_init_memory( &set->pool[c], address + offset, part, class_size[c] );
+
+        offset += part;
+        offset = (offset + 7) & ~7UL;
+        if( offset > size )
+            offset = size;
+    }
+
+    set->classes = classes;
+    set->max_size = set->pool[classes - 1].data_size;
+    for( set->shift = 0; ((set->max_size - 1) >> set->shift) >= _POOL_CLASS_LOOKUP; )
+        set->shift++;
+
+    for( i = 0, c = 0; i <= ((set->max_size - 1) >> set->shift); ++i )
+    {
+        while( set->pool[c].data_size < (i << set->shift) + 1 )
+            c++;
+        set->lookup[i] = c;
+    }
+
+    return 0;
+}/* end _os_pool_classes_setup */
+
+int OS_PoolCreateClasses(
+        void *address, 
+        uint32_t size, 
+        const uint32_t class_size[], 
+        const uint32_t class_buffers[], 
+        uint32_t classes, 
+        uint32_t *id)
+{
+    uint32_t possible_id;
+
+    _CHECK_POOL_INIT();
+
+    /*  Sanity checks   */
+    if( (address == NULL) || (class_size == NULL) || (class_buffers == NULL) || (id == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( (classes == 0) || (classes > OS_MAX_POOL_CLASSES) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    WLOCK();
+    {
+        for( possible_id = 0; possible_id < OS_MAX_POOL_CLASS_SETS; ++possible_id)
+        {
+            if( os_pool_classes[possible_id].free == TRUE )
+                break;
+        }
+
+        if( possible_id >= OS_MAX_POOL_CLASS_SETS )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        if( _os_pool_classes_setup( &os_pool_classes[possible_id], 
+                    (uint8_t*)address, size, class_size, class_buffers, classes ) < 0 )
+        {
+            WUNLOCK();
+            return -1;
+        }
+
+        os_pool_classes[possible_id].free = FALSE;
+        _os_pool_index_rebuild();
+    }
+    WUNLOCK();
+
+    *id = possible_id;
+
+    return 0;
+}
+
+int OS_PoolDeleteClasses(uint32_t id)
+{
+    OS_pool_classes_t *set;
+    uint32_t c;
+
+    _CHECK_POOL_INIT();
+
+    if( (id >= OS_MAX_POOL_CLASS_SETS) || os_pool_classes[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    set = &os_pool_classes[id];
+
+    WLOCK();
+    {
+        for( c = 0; c < set->classes; ++c )
+        {
+            if( lf_pool_num_free_elements(&set->pool[c]) != set->pool[c].num_elements )
+            {
+                WUNLOCK();
+                os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+            }
+        }
+
+        set->free = TRUE;
+        _os_pool_index_rebuild();
+    }
+    WUNLOCK();
+
+    return 0;
+}
+
+int OS_PoolAlloc(uint32_t id, uint32_t size, void **buffer)
+{
+    OS_pool_classes_t *set;
+    uint32_t c;
+
+    _CHECK_POOL_INIT();
+
+    if( (id >= OS_MAX_POOL_CLASS_SETS) || os_pool_classes[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    ASSERT( buffer != NULL );
+    if( buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    set = &os_pool_classes[id];
+
+    if( (size == 0) || (size > set->max_size) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    c = set->lookup[(size - 1) >> set->shift];
+    while( size > set->pool[c].data_size )
+        c++;
+
+    /*  The larger classes are used when the fitting one is exhausted   */
+    for( ; c < set->classes; ++c )
+    {
+        *buffer = lf_pool_alloc_elem( &set->pool[c] );
+        if( *buffer != NULL )
+            return 0;
+    }
+
+    os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+}
+
+int OS_PoolFree(uint32_t id, void *buffer)
+{
+    OS_pool_classes_t *set;
+    uint32_t c;
+
+    _CHECK_POOL_INIT();
+
+    if( (id >= OS_MAX_POOL_CLASS_SETS) || os_pool_classes[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    ASSERT( buffer != NULL );
+    if( buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    set = &os_pool_classes[id];
+
+    for( c = 0; c < set->classes; ++c )
+    {
+        if( lf_pool_free_elem( &set->pool[c], buffer ) == 0 )
+            return 0;
+    }
+
+    os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+}
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_FreeBuffer
+ *  Description:  Returns a buffer to the pool or size class allocator it
+ *  was taken from, found in the address index.
+ *  Parameters:
+ *      - buffer:   buffer to be returned
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the buffer belongs to no pool
+ * =====================================================================================
+ */
+int OS_FreeBuffer(void *buffer)
+{
+    uint32_t owner;
+
+    _CHECK_POOL_INIT();
+
+    ASSERT( buffer != NULL );
+    if( buffer == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    owner = _os_pool_index_find(buffer);
+    if( owner == 0 )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( owner <= OS_MAX_POOLS )
+        return OS_ReturnPoolBuffer(owner - 1, buffer);
+
+    return OS_PoolFree(owner - OS_MAX_POOLS - 1, buffer);
+
+}/* end OS_FreeBuffer */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_PoolGetInfo
+ *  Description:  Retrieves the usage of the pool. The rates are worked out
+ *  from the newest sample at least OS_POOL_RATE_WINDOW milliseconds old, or
+ *  the oldest one while there is none.
+ *  Parameters:
+ *      - id:       pool identifier
+ *      - prop:     structure where the usage will be stored
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the pool or the structure are not valid
+ * =====================================================================================
+ */
+int OS_PoolGetInfo(uint32_t id, OS_pool_prop_t *prop)
+{
+    OS_pool_t *pool;
+    OS_pool_sample_t *base, *sample;
+    uint32_t now, elapsed, gets, returns, i, n;
+
+    _CHECK_POOL_INIT();
+
+    if( (id >= OS_MAX_POOLS) || os_pool[id].free == TRUE )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    ASSERT( prop != NULL );
+    if( prop == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    pool = &os_pool[id];
+    now = _os_pool_msecs();
+
+    WLOCK();
+    {
+        _os_pool_sample(id, now);
+
+        n = (pool->samples < _POOL_RATE_SAMPLES) ? pool->samples : _POOL_RATE_SAMPLES;
+        base = &pool->sample[(pool->samples - n) % _POOL_RATE_SAMPLES];
+        for( i = 1; i <= n; ++i )
+        {
+            sample = &pool->sample[(pool->samples - i) % _POOL_RATE_SAMPLES];
+            if( now - sample->msecs >= OS_POOL_RATE_WINDOW )
+            {
+                base = sample;
+                break;
+            }
+        }
+
+        prop->mul_Cached = 0;
+#if (OS_POOL_MAGAZINE_SIZE > 0)
+        prop->mul_Cached = _os_pool_cached(id);
+#endif
+        if( _POOL_IS_GROWABLE(id) )
+        {
+            prop->mul_BufferSize = pool->pool.data_size;
+            prop->mul_Buffers = pool->max_slabs * pool->slab_buffers;
+        }
+        else if( _POOL_IS_LOCKFREE(id) )
+        {
+            prop->mul_BufferSize = pool->lf_pool.data_size;
+            prop->mul_Buffers = pool->lf_pool.num_elements;
+        }
+        else
+        {
+            prop->mul_BufferSize = pool->pool.data_size;
+            prop->mul_Buffers = pool->pool.memory_area_size / pool->pool.data_size;
+        }
+    }
+    WUNLOCK();
+
+    /*
+     * The counters are sampled without stopping the tasks taking and
+     * returning buffers, as OS_QueueGetInfo() does
+     */
+    _os_pool_totals(id, &gets, &returns);
+    prop->mul_Allocated = pool->allocated;
+    prop->mul_PeakAllocated = pool->peak;
+    prop->mul_Allocs = gets;
+    prop->mul_Frees = returns;
+    prop->mul_Failures = pool->failures;
+
+    /*  Averaged over the whole window while the pool is younger   */
+    elapsed = now - base->msecs;
+    if( elapsed < OS_POOL_RATE_WINDOW )
+        elapsed = OS_POOL_RATE_WINDOW;
+    prop->mul_AllocRate = (uint32_t)((uint64_t)(gets - base->gets) * 1000 / elapsed);
+    prop->mul_FreeRate = (uint32_t)((uint64_t)(returns - base->returns) * 1000 / elapsed);
+
+    for( i = 0; i <= OS_MAX_TASKS; ++i )
+        prop->mul_Held[i] = pool->held[i];
+
+    return 0;
+
+}/* end OS_PoolGetInfo */
+
+#endif
@@ -23,12 +23,23 @@
 #include <osal/osstats.h>
 #include <public/lock.h>
 #include <public/list.h>
+#include <public/bit_util.h>
+#include <public/spinlock.h>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#if defined(CONFIG_LINUX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 #include "pool.h"
+#include "ring.h"
 
 #define INIT_THREAD_MUTEX() \
     do{ \
@@ -64,463 +75,3212 @@ static uint8_t _queue_is_init = 0;
 
 /********************************* FILE CLASSES/STRUCTURES */
 
+/*
+ * Every element of a queue pool holds the message descriptor immediately
+ * followed by the message payload. Descriptors are therefore carved from the
+ * queue's own buffer and one queue can never starve the others.
+ */
 typedef struct os_queue_message
 {
     struct s_list_head  list;
-    void                *msg_data;
     uint32_t            msg_size;
     uint32_t            msg_prio;
+    /*  Time the message was queued, in microseconds since boot  */
+    uint32_t            msg_stamp;
+    /*  Deadline of the OS_QUEUE_DEADLINE queues in microseconds, relative to
+     *  msg_stamp until the message is queued, then to the heap epoch    */
+    uint32_t            msg_deadline;
+    /*  Who holds the slot, so a commit or a release not matching it is
+     *  rejected rather than corrupting the queue   */
+    volatile uint32_t   msg_state;
+    /*  Ring sequence number the slot of an OS_QUEUE_MPMC queue was reserved
+     *  or borrowed with    */
+    uint32_t            msg_seq;
 }msg_t;
 
+#define _QUEUE_MSG_FREE         0   /*  Free, in the pool or the ring   */
+#define _QUEUE_MSG_RESERVED     1   /*  Reserved by a producer  */
+#define _QUEUE_MSG_QUEUED       2   /*  Waiting for a consumer  */
+#define _QUEUE_MSG_BORROWED     3   /*  Borrowed by a consumer  */
+
+/** Align the sizes to the pointer size so descriptors are never misaligned */
+#define _QUEUE_ALIGN(x) \
+    (((x) + sizeof(void *) - 1) & ~((uint32_t)sizeof(void *) - 1))
+
+/** Size of the message descriptor stored in front of each payload */
+#define _QUEUE_MSG_HDR_SIZE     _QUEUE_ALIGN(sizeof(msg_t))
+
+/** Payload address of the message 'msg' */
+#define _QUEUE_MSG_DATA(msg)    ((void *)((uint8_t *)(msg) + _QUEUE_MSG_HDR_SIZE))
+
+/** Relative deadline, in microseconds, of a message 'ms' milliseconds ahead */
+#define _QUEUE_DEADLINE(ms) \
+    ((((ms) < OS_QUEUE_MAX_DEADLINE) ? (ms) : OS_QUEUE_MAX_DEADLINE) * 1000)
+
+/** Age of the heap epoch, in microseconds, the deadlines are rebased at. The
+ *  deadlines counted from the epoch then never get near to wrapping    */
+#define _QUEUE_EPOCH_SPAN       (1UL << 30)
+
+/** Messages handled per pool call by the batched put/get operations */
+#define _QUEUE_BATCH            16
+
+/*  The public buffer sizing macro must account for the descriptor  */
+typedef char _os_queue_msg_overhead_check
+    [(_QUEUE_MSG_HDR_SIZE <= OS_QUEUE_MSG_OVERHEAD) ? 1 : -1];
+typedef char _os_queue_mpmc_overhead_check
+    [(MPMC_RING_HDR_SIZE + _QUEUE_MSG_HDR_SIZE <= OS_QUEUE_MSG_OVERHEAD) ? 1 : -1];
+typedef char _os_queue_heap_overhead_check
+    [(sizeof(msg_t *) + _QUEUE_MSG_HDR_SIZE <= OS_QUEUE_MSG_OVERHEAD) ? 1 : -1];
+
+/*
+ * Messages of the OS_QUEUE_VARIABLE queues are records of the queue byte ring
+ * holding this descriptor followed by the payload. The record state tells the
+ * consumers whether the message can be retrieved and the ring whether the
+ * record can be freed.
+ */
+typedef struct os_queue_var_message
+{
+    uint32_t            msg_size;
+    uint32_t            msg_stamp;
+    /*  Bytes taken by the record in the ring   */
+    uint32_t            rec_size;
+    volatile uint32_t   rec_state;
+}vmsg_t;
+
+#define _QUEUE_REC_RESERVED     0   /*  Being written by the producer   */
+#define _QUEUE_REC_READY        1   /*  Waiting for a consumer  */
+#define _QUEUE_REC_READING      2   /*  Being read by a consumer    */
+#define _QUEUE_REC_DONE         3   /*  Read or released, can be freed  */
+
+/** Size of the record descriptor stored in front of each payload */
+#define _QUEUE_VAR_HDR_SIZE     _QUEUE_ALIGN(sizeof(vmsg_t))
+
+/** Payload address of the record 'rec' */
+#define _QUEUE_VAR_DATA(rec)    ((void *)((uint8_t *)(rec) + _QUEUE_VAR_HDR_SIZE))
+
+typedef char _os_queue_var_overhead_check
+    [(_QUEUE_VAR_HDR_SIZE <= OS_QUEUE_VAR_MSG_OVERHEAD) ? 1 : -1];
+
+/** Queue creation flags selecting the queue storage, at most one is set */
+#define _QUEUE_MODES            (OS_QUEUE_SPSC | OS_QUEUE_MPMC | OS_QUEUE_VARIABLE)
+
+/*
+ * Queue telemetry. The producers and the consumers update different cache
+ * lines; the current depth is the difference between puts and gets, less
+ * the messages overwritten or expired.
+ */
+struct os_queue_put_stats
+{
+    uint32_t puts;
+    uint32_t drops;
+    uint32_t peak;
+    /*  Messages discarded by OS_QUEUE_OVERWRITE queues */
+    uint32_t overwrites;
+};
+
+struct os_queue_get_stats
+{
+    uint32_t gets;
+    uint32_t latency[OS_QUEUE_LATENCY_BUCKETS];
+    /*  Messages discarded by OS_QUEUE_DROP_EXPIRED queues  */
+    uint32_t expired;
+};
+
 struct os_queue_msg_pool
 {
     struct s_pool pool;
     uint32_t allocated;
 };
 
+/*
+ * Pending messages are kept in one FIFO per priority level. The bitmap flags
+ * the non-empty levels so both insertion and removal are O(1).
+ */
+struct os_queue_msg_list
+{
+    uint32_t            bitmap;
+    struct s_list_head  level[OS_QUEUE_PRIO_LEVELS];
+};
+
+/*
+ * Pending messages of the OS_QUEUE_DEADLINE queues are kept in a binary
+ * min-heap ordered by deadline, stored after the message slots in the queue
+ * buffer, so both insertion and removal are O(log n). The deadlines are
+ * counted from the heap epoch, which moves forward as time goes by, so
+ * messages left overdue for any time still come first.
+ */
+struct os_queue_msg_heap
+{
+    msg_t               **msgs;
+    uint32_t            count;
+    /*  Order of the next message queued, breaks the deadline ties  */
+    uint32_t            seq;
+    /*  Time the deadlines are counted from, in microseconds since boot */
+    uint64_t            epoch;
+};
+
+#if defined(CONFIG_LINUX)
+/*
+ * Memory region of a queue shared by several processes, named after the
+ * queue. It holds the ring, the semaphores and the waiting producers count
+ * of the queue and it is followed by the ring slots. The creator sets
+ * 'magic' once the region is ready to be attached.
+ */
+#define _QUEUE_SHM_MAGIC        0x4f53514dUL
+
+struct os_queue_shm
+{
+    volatile uint32_t           magic;
+    /*  Bytes of the region, slots included */
+    uint32_t                    size;
+    uint32_t                    data_size;
+    volatile uint32_t           put_waiting;
+    char                        name[OS_QUEUE_NAME_MAX];
+    sem_t                       msgs_sem;
+    sem_t                       space_sem;
+    struct s_mpmc_ring          ring;
+};
+#endif
+
 typedef struct
 {
+    /*  Protects msg_pool and msg_list. Every queue record starts a cache
+     *  line so traffic on independent queues does not share any    */
+    spinlock_t                  lock CACHE_ALIGNED;
     struct os_queue_msg_pool    msg_pool;
-    struct s_list_head          msg_list;
+    struct os_queue_msg_list    msg_list;
+    struct os_queue_msg_heap    msg_heap;
     int                         free;
     int                         mul_Creator;
     int32_t                     is_blocking;
+    uint32_t                    flags;
+    uint32_t                    data_size;
     uint32_t                    semid;
+    /*  Counting semaphore the OS_QueuePutTimed() producers sleep on while
+     *  the queue is full, and the number of them waiting. Both semaphores
+     *  are created the first time they are needed and kept for the next
+     *  queues using the entry */
+    uint32_t                    space_semid;
+    volatile uint32_t           *put_waiting;
+    volatile uint32_t           put_waiters;
+    int                         sem_created;
+    int                         space_created;
+    /*  OS_QueueSelect() waiters, one bit per os_queue_select_table entry */
+    volatile uint32_t           select_mask;
+    struct os_queue_put_stats   put_stats CACHE_ALIGNED;
+    struct os_queue_get_stats   get_stats CACHE_ALIGNED;
+    /*  Message slots of the OS_QUEUE_SPSC queues   */
+    struct s_spsc_ring          ring;
+    /*  Message slots of the OS_QUEUE_MPMC queues. The ring and the waiting
+     *  producers count are the ones of the record, or the ones in the
+     *  memory region of the shared queues  */
+    struct s_mpmc_ring          *mpmc_ring;
+    struct s_mpmc_ring          mpmc;
+    struct os_queue_shm         *shm;
+    int                         shm_owner;
+    /*  Message records of the OS_QUEUE_VARIABLE queues, protected by lock  */
+    struct s_byte_ring          bytes;
 }OS_queue_record_t;
 
+#define _QUEUE_LOCK(queue_id, level) \
+    spin_lock(&os_queue_table[(queue_id)].lock, level)
 
-/********************************* FILE PRIVATE VARIABLES  */
+#define _QUEUE_UNLOCK(queue_id, level) \
+    spin_unlock(&os_queue_table[(queue_id)].lock, level)
+
+#define _QUEUE_IS_SPSC(queue_id) \
+    (os_queue_table[(queue_id)].flags & OS_QUEUE_SPSC)
+
+#define _QUEUE_IS_MPMC(queue_id) \
+    (os_queue_table[(queue_id)].flags & OS_QUEUE_MPMC)
+
+#define _QUEUE_IS_VAR(queue_id) \
+    (os_queue_table[(queue_id)].flags & OS_QUEUE_VARIABLE)
+
+#define _QUEUE_IS_OVERWRITE(queue_id) \
+    (os_queue_table[(queue_id)].flags & OS_QUEUE_OVERWRITE)
+
+#define _QUEUE_IS_DEADLINE(queue_id) \
+    (os_queue_table[(queue_id)].flags & OS_QUEUE_DEADLINE)
+
+#define _QUEUE_IS_SHARED(queue_id) \
+    (os_queue_table[(queue_id)].shm != NULL)
+
+#define _QUEUE_MPMC(queue_id) \
+    (os_queue_table[(queue_id)].mpmc_ring)
+
+
+/*
+ * Task waiting in OS_QueueSelect(). The binary semaphore is created the first
+ * time the entry is used and kept for the next waiters.
+ */
+typedef struct
+{
+    int                         free;
+    int                         created;
+    uint32_t                    semid;
+}OS_queue_select_t;
 
-#define OS_MAX_PENDING_MSG  25
+/*  The waiters of a queue are flagged in its 32-bit select mask    */
+typedef char _os_queue_select_mask_check[(OS_MAX_QUEUE_SELECTS <= 32) ? 1 : -1];
+
+/********************************* FILE PRIVATE VARIABLES  */
 
 /** This array contain all queue structures */
 static OS_queue_record_t        os_queue_table[OS_MAX_QUEUES];
-static struct os_queue_message  os_msg_list[OS_MAX_PENDING_MSG];
-LIST_HEAD(os_free_msg_list);
+
+/** This array contain the OS_QueueSelect() waiters */
+static OS_queue_select_t        os_queue_select_table[OS_MAX_QUEUE_SELECTS];
+
+#if defined(CONFIG_LINUX)
+/*
+ * Recording of the messages put, see OS_QueueRecordStart(). The putting
+ * tasks append the log entries to the byte ring under 'lock' and the writer
+ * task alone moves 'tail' as it writes them to the log file.
+ */
+#define _QUEUE_REC_PERIOD       1       /*  Writer polling period, in ms    */
+#define _QUEUE_REC_STACK        16384
+#define _QUEUE_REC_PRIO         OS_TASK_MAX_PRIORITY
+
+struct os_queue_rec
+{
+    spinlock_t                  lock;
+    volatile uint32_t           active;
+    volatile uint32_t           running;
+    uint8_t                     *buffer;
+    /*  Power of two size of 'buffer', and the free running counters of the
+     *  bytes appended and written  */
+    uint32_t                    size;
+    volatile uint32_t           head;
+    volatile uint32_t           tail;
+    uint32_t                    lost;
+    int                         failed;
+    int                         fd;
+    uint32_t                    writer;
+    /*  Given by the writer task once the whole log is written  */
+    uint32_t                    done_semid;
+};
+
+static struct os_queue_rec      os_queue_rec;
+#endif
 
 /********************************* PRIVATE INTERFACE    */
 
-/* This function adds a free message to the msg free list  */
-static void _os_queue_return_free_msg(struct os_queue_message *msg)
+static void _os_queue_init_msg_list(struct os_queue_msg_list *msg_list)
 {
-    bzero(msg, sizeof(struct os_queue_message));
-    list_add_tail(&msg->list, &os_free_msg_list);
-    ASSERT( !list_empty(&os_free_msg_list) );
+    int i;
+
+    msg_list->bitmap = 0;
+    for(i = 0; i < OS_QUEUE_PRIO_LEVELS; i++)
+        INIT_LIST_HEAD(&msg_list->level[i]);
 }
 
-/*  This function returns a free message    */
-static msg_t *_os_queue_get_free_msg(void)
+static void _os_queue_put_msg(msg_t *msg, struct os_queue_msg_list *msg_list)
 {
-    msg_t *msg;
+    uint32_t level;
+
+    level = (msg->msg_prio < OS_QUEUE_PRIO_LEVELS) ? 
+        msg->msg_prio : (OS_QUEUE_PRIO_LEVELS - 1);
+
+    list_add_tail(&msg->list, &msg_list->level[level]);
+    msg_list->bitmap |= (1UL << level);
+}
 
-    if( list_empty(&os_free_msg_list) ) return NULL;
+/*  Appends the already linked messages in 'msgs' to the 'level' FIFO  */
+static void _os_queue_put_msgs(struct s_list_head *msgs, uint32_t level, 
+        struct os_queue_msg_list *msg_list)
+{
+    if( level >= OS_QUEUE_PRIO_LEVELS )
+        level = OS_QUEUE_PRIO_LEVELS - 1;
+
+    list_splice_tail(msgs, &msg_list->level[level]);
+    if( !list_empty(&msg_list->level[level]) )
+        msg_list->bitmap |= (1UL << level);
+}
+
+/*  Dequeues the oldest message of the non-empty 'level' FIFO   */
+static msg_t *_os_queue_get_level_msg(struct os_queue_msg_list *msg_list, 
+        uint32_t level)
+{
+    msg_t *msg;
 
-    msg = list_first_entry(&os_free_msg_list, msg_t, list);
-    if( msg != NULL ) list_del(&msg->list);
+    msg = list_first_entry(&msg_list->level[level], msg_t, list);
+    list_del(&msg->list);
+    if( list_empty(&msg_list->level[level]) )
+        msg_list->bitmap &= ~(1UL << level);
 
     return msg;
 }
 
-static void _os_queue_put_msg(msg_t *msg, struct s_list_head *msg_list)
+static msg_t *_os_queue_get_msg(struct os_queue_msg_list *msg_list)
+{
+    if( msg_list->bitmap == 0 ) return NULL;
+
+    /*  The highest non-empty level holds the next message  */
+    return _os_queue_get_level_msg(msg_list, bit_fls32(msg_list->bitmap));
+}
+
+/*  Dequeues the oldest message of the lowest non-empty level  */
+static msg_t *_os_queue_get_oldest_msg(struct os_queue_msg_list *msg_list)
+{
+    if( msg_list->bitmap == 0 ) return NULL;
+
+    return _os_queue_get_level_msg(msg_list, bit_ffs32(msg_list->bitmap));
+}
+
+/*  Current time in microseconds, used to stamp the messages   */
+static uint32_t _os_queue_stamp(void)
+{
+    OS_time_t t;
+
+    OS_GetTimeSinceBoot(&t);
+    return t.mul_Seconds * 1000000 + t.mul_MicroSeconds;
+}
+
+/*  Current time in milliseconds, used to work out the time left to wait  */
+static uint32_t _os_queue_msecs(void)
+{
+    OS_time_t t;
+
+    OS_GetTimeSinceBoot(&t);
+    return t.mul_Seconds * 1000 + t.mul_MicroSeconds / 1000;
+}
+
+/*  Current time in microseconds, wide enough to never wrap, used to count
+ *  the deadlines from the heap epoch   */
+static uint64_t _os_queue_clock(void)
+{
+    OS_time_t t;
+
+    OS_GetTimeSinceBoot(&t);
+    return (uint64_t)t.mul_Seconds * 1000000 + t.mul_MicroSeconds;
+}
+
+/*  Whether 'a' is retrieved before 'b'. The deadlines share the heap epoch
+ *  and do not wrap, equal deadlines are served in FIFO order   */
+static int _os_queue_msg_before(msg_t *a, msg_t *b)
+{
+    if( a->msg_deadline != b->msg_deadline )
+        return a->msg_deadline < b->msg_deadline;
+
+    return (int32_t)(a->msg_prio - b->msg_prio) < 0;
+}
+
+/*  Stores 'msg' at the place 'i' of the heap or below it  */
+static void _os_queue_heap_sift(struct os_queue_msg_heap *heap, uint32_t i, 
+        msg_t *msg)
 {
-    struct s_list_head *ptr;
-    msg_t *entry;
+    uint32_t child;
 
-    list_for_each(ptr, msg_list)
+    for( ; (child = 2 * i + 1) < heap->count; i = child )
     {
-        entry = list_entry(ptr, msg_t, list);
-        if(entry->msg_prio < msg->msg_prio )
-        {
-            list_add_tail(&msg->list, ptr);
-            return;
-        }
+        if( (child + 1 < heap->count) && 
+                _os_queue_msg_before(heap->msgs[child + 1], heap->msgs[child]) )
+            child++;
+        if( !_os_queue_msg_before(heap->msgs[child], msg) )
+            break;
+        heap->msgs[i] = heap->msgs[child];
     }
-    list_add_tail(&msg->list, msg_list);
+    heap->msgs[i] = msg;
 }
 
-static msg_t *_os_queue_get_msg(struct s_list_head *msg_list)
+/*
+ * Moves the heap epoch to 'now'. The deadlines already passed at 'now' are
+ * clamped to it, they all come first and in FIFO order, so the heap is built
+ * again.
+ */
+static void _os_queue_heap_rebase(struct os_queue_msg_heap *heap, uint64_t now)
 {
-    msg_t *msg;
-    if( list_empty(msg_list) ) return NULL;
+    uint64_t shift = now - heap->epoch;
+    uint32_t i;
 
-    msg = list_first_entry(msg_list, msg_t, list);
-    if( msg != NULL) list_del(&msg->list);
+    for( i = 0; i < heap->count; i++ )
+    {
+        if( heap->msgs[i]->msg_deadline > shift )
+            heap->msgs[i]->msg_deadline -= (uint32_t)shift;
+        else
+            heap->msgs[i]->msg_deadline = 0;
+    }
+    for( i = heap->count / 2; i-- > 0; )
+        _os_queue_heap_sift(heap, i, heap->msgs[i]);
 
-    return msg;
+    heap->epoch = now;
 }
 
-static void _os_queue_init(void)
+static void _os_queue_heap_push(struct os_queue_msg_heap *heap, msg_t *msg, 
+        uint64_t now)
 {
-    int i;
+    uint64_t deadline;
+    uint32_t i, parent, lag;
 
-    STATS_INIT_QUEUE();
+    if( now - heap->epoch >= _QUEUE_EPOCH_SPAN )
+        _os_queue_heap_rebase(heap, now);
 
-    /* Initialize Message Queue Table */
+    /*  The deadline was relative to the message stamp  */
+    lag = (uint32_t)now - msg->msg_stamp;
+    deadline = (now - heap->epoch) + msg->msg_deadline;
+    msg->msg_deadline = (deadline > lag) ? (uint32_t)(deadline - lag) : 0;
 
-    for(i = 0; i < OS_MAX_QUEUES; i++)
+    /*  The priority is in the deadline, msg_prio keeps the queuing order   */
+    msg->msg_prio = heap->seq++;
+    for( i = heap->count++; i > 0; i = parent )
     {
-        os_queue_table[i].free        = TRUE;
-        os_queue_table[i].mul_Creator     = UNINITIALIZED;
-        os_queue_table[i].is_blocking = UNINITIALIZED;
+        parent = (i - 1) / 2;
+        if( !_os_queue_msg_before(msg, heap->msgs[parent]) )
+            break;
+        heap->msgs[i] = heap->msgs[parent];
+    }
+    heap->msgs[i] = msg;
+}
 
-        INIT_LIST_HEAD(&os_queue_table[i].msg_list);
-        pool_init(&os_queue_table[i].msg_pool.pool);
+static msg_t *_os_queue_heap_pop(struct os_queue_msg_heap *heap)
+{
+    msg_t *top;
 
-        /*  Create all semaphores to be used in the message queue   */
-        if( OS_CountSemCreate (&os_queue_table[i].semid, 0, 0) < 0 ) 
-        {
-            printf("%s:%d: ERROR!!!\n", __func__, __LINE__);
-        }
+    if( heap->count == 0 ) return NULL;
+
+    /*  The last message sifts down from the root   */
+    top = heap->msgs[0];
+    heap->count--;
+    _os_queue_heap_sift(heap, 0, heap->msgs[heap->count]);
+
+    return top;
+}
+
+/*  Queues 'msg' as the queue discipline says. The caller holds the lock   */
+static void _os_queue_enqueue(uint32_t queue_id, msg_t *msg)
+{
+    msg->msg_state = _QUEUE_MSG_QUEUED;
+    if( _QUEUE_IS_DEADLINE(queue_id) )
+        _os_queue_heap_push(&os_queue_table[queue_id].msg_heap, msg, 
+                _os_queue_clock());
+    else
+        _os_queue_put_msg(msg, &os_queue_table[queue_id].msg_list);
+}
+
+/*  Queues the 'prio' messages linked in 'msgs'. The caller holds the lock */
+static void _os_queue_enqueue_msgs(uint32_t queue_id, struct s_list_head *msgs, 
+        uint32_t prio)
+{
+    uint64_t now;
+    msg_t *msg;
+
+    if( !_QUEUE_IS_DEADLINE(queue_id) )
+    {
+        _os_queue_put_msgs(msgs, prio, &os_queue_table[queue_id].msg_list);
+        return;
     }
 
-    /*  Add all messages to the msg free list   */
-    for(i = 0; i < OS_MAX_PENDING_MSG; i++)
+    now = _os_queue_clock();
+    while( !list_empty(msgs) )
     {
-        _os_queue_return_free_msg(&os_msg_list[i]);
+        msg = list_first_entry(msgs, msg_t, list);
+        list_del(&msg->list);
+        _os_queue_heap_push(&os_queue_table[queue_id].msg_heap, msg, now);
     }
+}
 
-    INIT_THREAD_MUTEX();
+/*  Dequeues the next message to be retrieved. The caller holds the lock  */
+static msg_t *_os_queue_dequeue(uint32_t queue_id)
+{
+    if( _QUEUE_IS_DEADLINE(queue_id) )
+        return _os_queue_heap_pop(&os_queue_table[queue_id].msg_heap);
+
+    return _os_queue_get_msg(&os_queue_table[queue_id].msg_list);
 }
 
+/*
+ * Adds 'n' to a telemetry counter. Only the SPSC queues have a single
+ * writer for each counter, elsewhere concurrent tasks update them.
+ */
+static uint32_t _os_queue_stats_add(uint32_t queue_id, uint32_t *counter, uint32_t n)
+{
+    if( _QUEUE_IS_SPSC(queue_id) )
+        return (*counter += n);
 
-/********************************* PUBLIC  INTERFACE    */
+    return atomic_add32(counter, n);
+}
 
-/****************************************************************************************
-  MESSAGE QUEUE API
- ****************************************************************************************/
+/*  Accounts 'n' messages that could not be queued  */
+static void _os_queue_stats_drop(uint32_t queue_id, uint32_t n)
+{
+    _os_queue_stats_add(queue_id, &os_queue_table[queue_id].put_stats.drops, n);
+}
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  OS_QueueCreate
- *  Description:  This function creates a message queue.
- *  Parameters:
- *      - queue_id:     This is the queue identifier to be returned
- *      - queue_name:   This parameter must be NULL.
- *      - queue_depth:  This is the depth of the queue
- *      - data_size:    This is the size of the data to be stored in the queue
- *      - flags:        Not used so far.
- *  Return:
- *      0 when the call success
- *      OS_STATUS_EINVAL when there is not valid pointers passed as parameters
- *      OS_STATUS_NAME_TOO_LONG when the queue name is too long
- *      OS_STATUS_NO_FREE_IDS when there are no more identifiers for the queues
- *      OS_STATUS_NAME_TAKEN when the 'queue_name' is already in use
- *      OS_STATUS_EERR when any other error occurs
- *
- * =====================================================================================
+/*  Accounts 'n' queued messages and the depth they take the queue to  */
+static void _os_queue_stats_put(uint32_t queue_id, uint32_t n)
+{
+    struct os_queue_put_stats *stats = &os_queue_table[queue_id].put_stats;
+    int32_t depth;
+    uint32_t peak;
+
+    depth = (int32_t)(_os_queue_stats_add(queue_id, &stats->puts, n) -
+            os_queue_table[queue_id].get_stats.gets - stats->overwrites - 
+            os_queue_table[queue_id].get_stats.expired);
+
+    while( (depth > 0) && ((peak = stats->peak) < (uint32_t)depth) )
+    {
+        if( atomic_cas32(&stats->peak, peak, depth) )
+            break;
+    }
+}
+
+/*  Accounts a retrieved message queued at 'stamp' and the time it waited */
+static void _os_queue_stats_get(uint32_t queue_id, uint32_t stamp)
+{
+    struct os_queue_get_stats *stats = &os_queue_table[queue_id].get_stats;
+    uint32_t wait, bucket;
+
+    wait = _os_queue_stamp() - stamp;
+    bucket = (wait == 0) ? 0 : bit_fls32(wait) + 1;
+    if( bucket >= OS_QUEUE_LATENCY_BUCKETS )
+        bucket = OS_QUEUE_LATENCY_BUCKETS - 1;
+
+    _os_queue_stats_add(queue_id, &stats->latency[bucket], 1);
+    _os_queue_stats_add(queue_id, &stats->gets, 1);
+}
+
+/*
+ * Wakes up the OS_QueuePutTimed() producers waiting for room once 'n' message
+ * slots have been given back. The room shall be visible before the waiters
+ * are counted, as they register before trying again.
  */
-int OS_QueueCreate (
-        uint32_t *queue_id, 
-        char     *buffer,
-        uint32_t buffer_size,
-        uint32_t queue_depth, 
-        uint32_t data_size, 
-        uint32_t flags)
+static void _os_queue_space_signal(uint32_t queue_id, uint32_t n)
 {
-    uint32_t size_aligned;
+    uint32_t waiting;
 
-    ASSERT(queue_id);
+    atomic_mb();
+    waiting = *os_queue_table[queue_id].put_waiting;
+    if( waiting == 0 ) return;
 
-    _CHECK_QUEUE_INIT();
+    if( n > waiting ) n = waiting;
+    if( n == 1 )
+        OS_CountSemGive(os_queue_table[queue_id].space_semid);
+    else
+        OS_CountSemGiveMany(os_queue_table[queue_id].space_semid, n);
+}
 
-    uint32_t possible_qid;
+/*  Gives the slot of 'msg' back to the queue pool  */
+static void _os_queue_free_msg(uint32_t queue_id, msg_t *msg)
+{
+    int32_t level;
+
+    msg->msg_state = _QUEUE_MSG_FREE;
+    _QUEUE_LOCK(queue_id, level);
+    pool_free_elem( &os_queue_table[queue_id].msg_pool.pool, msg );
+    os_queue_table[queue_id].msg_pool.allocated--;    // decrease the allocated buffers
+    _QUEUE_UNLOCK(queue_id, level);
+    _os_queue_space_signal(queue_id, 1);
+}
 
-    /*  Sanity checks   */
-    if ( queue_id == NULL )
+/*  Discards the expired message 'msg'  */
+static void _os_queue_drop_expired(uint32_t queue_id, msg_t *msg)
+{
+    _os_queue_free_msg(queue_id, msg);
+    _os_queue_stats_add(queue_id, &os_queue_table[queue_id].get_stats.expired, 1);
+}
+
+/*
+ * Takes a unit of the queue counting semaphore according to the queue
+ * blocking mode and 'timeout'. Returns -1 and sets os_errno otherwise.
+ */
+static int _os_queue_take(uint32_t queue_id, int32_t timeout)
+{
+    if( timeout > 0 )
     {
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( OS_CountSemTimedWait(os_queue_table[queue_id].semid, timeout) < 0 )
+        {
+            os_errno = OS_STATUS_TIMEOUT;
+            return -1;
+        }
     }
-    else if ( buffer == NULL )
+    else if( os_queue_table[queue_id].is_blocking == OS_BLOCKING )
     {
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( OS_CountSemTake(os_queue_table[queue_id].semid) < 0 )
+        {
+            os_errno = OS_STATUS_EERR;
+            return -1;
+        }
     }
-    else if( (int)buffer & 0x3 )
+    else if( OS_CountSemTryTake(os_queue_table[queue_id].semid) < 0 )
     {
-        printf("%s:%d: Buffer not aligned (0x%x)\n", __func__, __LINE__, (int)buffer);
-        os_return_minus_one_and_set_errno(OS_STATUS_ADDRESS_MISALIGNED);
+        os_errno = OS_STATUS_EERR;
+        return -1;
     }
 
-    if(queue_depth == 0 || data_size == 0)
+    return 0;
+}
+
+/*  Whether the dequeued 'msg' of an OS_QUEUE_DROP_EXPIRED queue is past its
+ *  deadline. The caller holds the lock, so the heap epoch did not move */
+static int _os_queue_expired(uint32_t queue_id, msg_t *msg)
+{
+    if( !(os_queue_table[queue_id].flags & OS_QUEUE_DROP_EXPIRED) )
+        return 0;
+
+    return _os_queue_clock() - os_queue_table[queue_id].msg_heap.epoch > 
+        msg->msg_deadline;
+}
+
+/*
+ * Waits according to the queue blocking mode and 'timeout' until a message is
+ * available and dequeues it. NULL is returned and os_errno set otherwise.
+ * Expired messages take the semaphore unit of a retrieved message, so they
+ * are discarded and the call waits again.
+ */
+static msg_t *_os_queue_wait_msg(uint32_t queue_id, int32_t timeout)
+{
+    int32_t level;
+    int expired;
+    msg_t *msg;
+
+    for(;;)
     {
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( _os_queue_take(queue_id, timeout) < 0 ) return NULL;
+
+        _QUEUE_LOCK(queue_id, level);
+        msg = _os_queue_dequeue(queue_id);
+        expired = (msg != NULL) && _os_queue_expired(queue_id, msg);
+        _QUEUE_UNLOCK(queue_id, level);
+
+        /*
+         * Check the status of the read operation.  If a valid message was
+         * obtained, indicate success.  If an error occurred, send an event
+         * to indicate an unexpected queue read error.
+         */
+        if( msg == NULL )
+        {
+            os_errno = OS_STATUS_EERR;
+            return NULL;
+        }
+
+        if( !expired )
+        {
+            _os_queue_stats_get(queue_id, msg->msg_stamp);
+            return msg;
+        }
+
+        _os_queue_drop_expired(queue_id, msg);
     }
-    else if ( (buffer_size == 0) || (buffer_size < data_size) )
+}
+
+/*
+ * Discards the oldest message of the lowest priority level of a full
+ * OS_QUEUE_OVERWRITE queue and returns its slot for a new message. A unit of
+ * the semaphore is taken first, as a consumer would do, so the message is not
+ * promised to any consumer. NULL is returned when all the queued messages
+ * are already being retrieved.
+ */
+static msg_t *_os_queue_recycle_msg(uint32_t queue_id)
+{
+    int32_t level;
+    msg_t *msg;
+
+    if( OS_CountSemTryTake(os_queue_table[queue_id].semid) < 0 )
+        return NULL;
+
+    _QUEUE_LOCK(queue_id, level);
+    msg = _os_queue_get_oldest_msg( &os_queue_table[queue_id].msg_list );
+    _QUEUE_UNLOCK(queue_id, level);
+
+    if( msg != NULL )
+        _os_queue_stats_add(queue_id, &os_queue_table[queue_id].put_stats.overwrites, 1);
+
+    return msg;
+}
+
+/*
+ * Wakes up the consumer of an OS_QUEUE_SPSC queue when it sleeps on the
+ * empty ring. The ring update shall be visible before 'waiting' is read.
+ */
+static void _os_queue_spsc_wake(uint32_t queue_id)
+{
+    struct s_spsc_ring *ring = &os_queue_table[queue_id].ring;
+
+    atomic_mb();
+    if( ring->waiting )
     {
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        ring->waiting = 0;
+        OS_CountSemGive(os_queue_table[queue_id].semid);
     }
+}
 
-    /* we don't want to allow names too long*/
-    /* if truncated, two names might be the same */
+/*
+ * Signals 'n' new messages of the queue to its consumers and wakes up the
+ * tasks waiting for it in OS_QueueSelect(). The messages shall be visible
+ * before the select mask is read, as the waiters register before checking
+ * the queue.
+ */
+static int _os_queue_signal(uint32_t queue_id, uint32_t n)
+{
+    uint32_t mask, i;
+    int ret = 0;
+
+    _os_queue_stats_put(queue_id, n);
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+        _os_queue_spsc_wake(queue_id);
+    else
+    {
+        if( n == 1 )
+            ret = OS_CountSemGive(os_queue_table[queue_id].semid);
+        else
+            ret = OS_CountSemGiveMany(os_queue_table[queue_id].semid, n);
+        atomic_mb();
+    }
+
+    mask = os_queue_table[queue_id].select_mask;
+    while( mask )
+    {
+        i = bit_fls32(mask);
+        mask &= ~(1UL << i);
+        OS_BinSemGive(os_queue_select_table[i].semid);
+    }
+
+    return ret;
+}
+
+/*  Whether the queue holds messages, without retrieving any    */
+static int _os_queue_has_msg(uint32_t queue_id)
+{
+    if( _QUEUE_IS_SPSC(queue_id) )
+        return spsc_ring_avail(&os_queue_table[queue_id].ring, 1) && 
+            (((msg_t *)spsc_ring_head_slot(&os_queue_table[queue_id].ring, 0))->msg_state != 
+             _QUEUE_MSG_BORROWED);
+    if( _QUEUE_IS_MPMC(queue_id) )
+        return mpmc_ring_ready(_QUEUE_MPMC(queue_id));
+    if( _QUEUE_IS_VAR(queue_id) )
+        return (int32_t)(os_queue_table[queue_id].put_stats.puts - 
+                os_queue_table[queue_id].get_stats.gets) > 0;
+
+    if( _QUEUE_IS_DEADLINE(queue_id) )
+        return os_queue_table[queue_id].msg_heap.count != 0;
+
+    return os_queue_table[queue_id].msg_list.bitmap != 0;
+}
+
+/*  Adds or removes the select waiter 'bit' on the 'count' queues   */
+static void _os_queue_select_register(uint32_t queue_ids[], uint32_t count,
+        uint32_t bit, int add)
+{
+    uint32_t i;
+    int32_t level;
+
+    for( i = 0; i < count; i++ )
+    {
+        _QUEUE_LOCK(queue_ids[i], level);
+        if( add )
+            os_queue_table[queue_ids[i]].select_mask |= bit;
+        else
+            os_queue_table[queue_ids[i]].select_mask &= ~bit;
+        _QUEUE_UNLOCK(queue_ids[i], level);
+    }
+}
+
+/*
+ * Accounts and returns the message at the head of an OS_QUEUE_SPSC ring. A
+ * borrowed message stays at the head until it is released, the consumer
+ * gets NULL and OS_STATUS_EBUSY meanwhile.
+ */
+static msg_t *_os_queue_spsc_head(uint32_t queue_id)
+{
+    msg_t *msg = spsc_ring_head_slot(&os_queue_table[queue_id].ring, 0);
+
+    if( msg->msg_state == _QUEUE_MSG_BORROWED )
+    {
+        os_errno = OS_STATUS_EBUSY;
+        return NULL;
+    }
+
+    _os_queue_stats_get(queue_id, msg->msg_stamp);
+    return msg;
+}
+
+/*
+ * Waits according to the queue blocking mode and 'timeout' until the ring of
+ * an OS_QUEUE_SPSC queue holds a message and returns it without consuming
+ * it. The counting semaphore is only used to sleep on the empty ring, so
+ * stale units just cause another check of the ring.
+ */
+static msg_t *_os_queue_spsc_wait(uint32_t queue_id, int32_t timeout)
+{
+    struct s_spsc_ring *ring = &os_queue_table[queue_id].ring;
+    int ret;
+
+    for(;;)
+    {
+        if( spsc_ring_avail(ring, 1) )
+            return _os_queue_spsc_head(queue_id);
+
+        if( (timeout <= 0) && 
+                (os_queue_table[queue_id].is_blocking == OS_NONBLOCKING) )
+        {
+            os_errno = OS_STATUS_EERR;
+            return NULL;
+        }
+
+        /*  Announce the wait and check again so no message is missed   */
+        ring->waiting = 1;
+        atomic_mb();
+        if( spsc_ring_avail(ring, 1) )
+        {
+            ring->waiting = 0;
+            return _os_queue_spsc_head(queue_id);
+        }
+
+        if( timeout > 0 )
+            ret = OS_CountSemTimedWait(os_queue_table[queue_id].semid, timeout);
+        else
+            ret = OS_CountSemTake(os_queue_table[queue_id].semid);
+
+        if( ret < 0 )
+        {
+            ring->waiting = 0;
+            if( spsc_ring_avail(ring, 1) )
+                return _os_queue_spsc_head(queue_id);
+
+            os_errno = (timeout > 0) ? OS_STATUS_TIMEOUT : OS_STATUS_EERR;
+            return NULL;
+        }
+    }
+}
+
+/*
+ * Consumes the slots of an OS_QUEUE_MPMC queue released without being
+ * committed found at the dequeue position. They take no semaphore unit, so
+ * an empty queue would otherwise look ready until the next message.
+ */
+static void _os_queue_mpmc_drain(uint32_t queue_id)
+{
+    struct s_mpmc_ring *ring = _QUEUE_MPMC(queue_id);
+    msg_t *msg;
+    uint32_t pos;
+
+    for(;;)
+    {
+        msg = mpmc_ring_peek(ring, &pos);
+        if( (msg == NULL) || msg->msg_size )
+            return;
+        if( !mpmc_ring_claim_at(ring, pos) )
+            continue;
+
+        msg->msg_state = _QUEUE_MSG_FREE;
+        mpmc_ring_publish_get(ring, msg);
+        _os_queue_space_signal(queue_id, 1);
+    }
+}
+
+/*
+ * Dequeues the next message of an OS_QUEUE_MPMC queue once a unit of its
+ * semaphore has been taken. The slot at the dequeue position may still be
+ * being filled by a slower producer, so the call yields until it is ready.
+ * Slots released without being committed are skipped, the ones left right
+ * after the message as well.
+ */
+static msg_t *_os_queue_mpmc_get(uint32_t queue_id)
+{
+    struct s_mpmc_ring *ring = _QUEUE_MPMC(queue_id);
+    msg_t *msg;
+
+    for(;;)
+    {
+        msg = mpmc_ring_claim_get(ring);
+        if( msg == NULL )
+        {
+            OS_TaskYield();
+            continue;
+        }
+        if( msg->msg_size )
+        {
+            _os_queue_stats_get(queue_id, msg->msg_stamp);
+            _os_queue_mpmc_drain(queue_id);
+            return msg;
+        }
+
+        msg->msg_state = _QUEUE_MSG_FREE;
+        mpmc_ring_publish_get(ring, msg);
+        _os_queue_space_signal(queue_id, 1);
+    }
+}
+
+/*
+ * Waits according to the queue blocking mode and 'timeout' until an
+ * OS_QUEUE_MPMC queue holds a message and dequeues it. The counting
+ * semaphore accounts the published messages as for the priority queues.
+ */
+static msg_t *_os_queue_mpmc_wait(uint32_t queue_id, int32_t timeout)
+{
+    if( _os_queue_take(queue_id, timeout) < 0 ) return NULL;
+
+    return _os_queue_mpmc_get(queue_id);
+}
+
+/*  Allocates the record of a 'size' bytes message of an OS_QUEUE_VARIABLE queue */
+static vmsg_t *_os_queue_var_alloc(uint32_t queue_id, uint32_t size)
+{
+    vmsg_t *rec;
+    int32_t level;
+
+    _QUEUE_LOCK(queue_id, level);
+    rec = byte_ring_alloc(&os_queue_table[queue_id].bytes, _QUEUE_VAR_HDR_SIZE + size);
+    if( rec != NULL )
+    {
+        rec->rec_size = BYTE_RING_ALIGN(_QUEUE_VAR_HDR_SIZE + size);
+        rec->rec_state = _QUEUE_REC_RESERVED;
+    }
+    _QUEUE_UNLOCK(queue_id, level);
+
+    return rec;
+}
+
+/*  Frees the records at the ring head already read and given back. The
+ *  caller shall hold the queue lock   */
+static void _os_queue_var_reclaim(struct s_byte_ring *ring)
+{
+    vmsg_t *rec;
+
+    while( ((rec = byte_ring_head_slot(ring)) != NULL) && 
+            (rec->rec_state == _QUEUE_REC_DONE) )
+        byte_ring_free(ring, rec->rec_size);
+}
+
+/*  Moves the reader past the records released without being committed and
+ *  frees them. The caller shall hold the queue lock    */
+static void _os_queue_var_skip(struct s_byte_ring *ring)
+{
+    vmsg_t *rec;
+
+    while( ((rec = byte_ring_read_slot(ring)) != NULL) && 
+            (rec->rec_state == _QUEUE_REC_DONE) )
+        byte_ring_read_next(ring, rec->rec_size);
+
+    _os_queue_var_reclaim(ring);
+}
+
+/*  Gives the record 'rec' back so its room can be reused   */
+static void _os_queue_var_free(uint32_t queue_id, vmsg_t *rec)
+{
+    int32_t level;
+
+    _QUEUE_LOCK(queue_id, level);
+    rec->rec_state = _QUEUE_REC_DONE;
+    _os_queue_var_skip(&os_queue_table[queue_id].bytes);
+    _QUEUE_UNLOCK(queue_id, level);
+    _os_queue_space_signal(queue_id, 1);
+}
+
+/*
+ * Retrieves the next message of an OS_QUEUE_VARIABLE queue once a unit of its
+ * semaphore has been taken. The message is copied out of the lock, so the
+ * record is only marked as being read. As for the OS_QUEUE_MPMC queues the
+ * next record may still be being written by a slower producer, and the
+ * records released without being committed are skipped.
+ */
+static vmsg_t *_os_queue_var_get(uint32_t queue_id)
+{
+    struct s_byte_ring *ring = &os_queue_table[queue_id].bytes;
+    int32_t level;
+    vmsg_t *rec;
+
+    for(;;)
+    {
+        _QUEUE_LOCK(queue_id, level);
+        rec = byte_ring_read_slot(ring);
+        if( (rec != NULL) && 
+                (atomic_load_acquire(&rec->rec_state) == _QUEUE_REC_READY) )
+        {
+            rec->rec_state = _QUEUE_REC_READING;
+            byte_ring_read_next(ring, rec->rec_size);
+            _os_queue_var_skip(ring);
+            _QUEUE_UNLOCK(queue_id, level);
+
+            _os_queue_stats_get(queue_id, rec->msg_stamp);
+            return rec;
+        }
+        _QUEUE_UNLOCK(queue_id, level);
+
+        OS_TaskYield();
+    }
+}
+
+/*
+ * Waits according to the queue blocking mode and 'timeout' until an
+ * OS_QUEUE_VARIABLE queue holds a message and retrieves it.
+ */
+static vmsg_t *_os_queue_var_wait(uint32_t queue_id, int32_t timeout)
+{
+    if( _os_queue_take(queue_id, timeout) < 0 ) return NULL;
+
+    return _os_queue_var_get(queue_id);
+}
+
+/*
+ * Returns the record of the payload 'data' handed out by OS_QueueReserve() or
+ * OS_QueueBorrow() on an OS_QUEUE_VARIABLE queue, or NULL when 'data' can not
+ * be the payload of any of its records.
+ */
+static vmsg_t *_os_queue_var_data_to_rec(uint32_t queue_id, void *data)
+{
+    struct s_byte_ring *ring = &os_queue_table[queue_id].bytes;
+    uint8_t *rec = (uint8_t *)data - _QUEUE_VAR_HDR_SIZE;
+
+    if( (rec < ring->memory_area) || (rec >= ring->memory_area + ring->size) )
+        return NULL;
+    if( ((uint32_t)(rec - ring->memory_area) % sizeof(void *)) != 0 )
+        return NULL;
+
+    return (vmsg_t *)rec;
+}
+
+/*
+ * Returns the message descriptor of the payload 'data' handed out by
+ * OS_QueueReserve() or OS_QueueBorrow(), or NULL when 'data' is not the
+ * payload of any of the queue slots.
+ */
+static msg_t *_os_queue_data_to_msg(uint32_t queue_id, void *data)
+{
+    struct s_pool *pool = &os_queue_table[queue_id].msg_pool.pool;
+    uint8_t *msg = (uint8_t *)data - _QUEUE_MSG_HDR_SIZE;
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        /*  Only the current head and tail slots are ever handed out    */
+        if( (msg != spsc_ring_tail_slot(&os_queue_table[queue_id].ring, 0)) &&
+                (msg != spsc_ring_head_slot(&os_queue_table[queue_id].ring, 0)) )
+            return NULL;
+        return (msg_t *)msg;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        struct s_mpmc_ring *ring = _QUEUE_MPMC(queue_id);
+        uint8_t *slot = MPMC_RING_SLOT(msg);
+
+        if( (slot < mpmc_ring_area(ring)) || 
+                (slot > mpmc_ring_slot(ring, ring->mask)) )
+            return NULL;
+        if( ((uint32_t)(slot - mpmc_ring_area(ring)) % ring->slot_size) != 0 )
+            return NULL;
+        return (msg_t *)msg;
+    }
+
+    if( (msg < pool->memory_area) || 
+            (msg >= pool->memory_area + pool->memory_area_size) )
+        return NULL;
+    if( ((uint32_t)(msg - pool->memory_area) % pool->data_size) != 0 )
+        return NULL;
+
+    return (msg_t *)msg;
+}
+
+/*
+ * Stores a message of 'size' bytes in the queue as the queue discipline
+ * says. Returns -1 and sets os_errno to OS_STATUS_QUEUE_FULL when there is
+ * no room for it, the drop being accounted by the caller.
+ */
+static int _os_queue_store(uint32_t queue_id, void *data, uint32_t size, uint32_t prio)
+{
+    uint32_t stamp = _os_queue_stamp();
+    msg_t *new;
+    vmsg_t *rec;
+    int32_t level;
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        if( spsc_ring_free(&os_queue_table[queue_id].ring, 1) == 0 )
+        {
+            os_errno = OS_STATUS_QUEUE_FULL;
+            return -1;
+        }
+
+        new = spsc_ring_tail_slot(&os_queue_table[queue_id].ring, 0);
+        new->msg_prio = prio;
+        new->msg_stamp = stamp;
+        new->msg_size = size;
+        new->msg_state = _QUEUE_MSG_QUEUED;
+        memcpy(_QUEUE_MSG_DATA(new), data, size);
+
+        spsc_ring_produce(&os_queue_table[queue_id].ring, 1);
+        _os_queue_signal(queue_id, 1);
+        return 0;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        new = mpmc_ring_claim_put(_QUEUE_MPMC(queue_id));
+        if( new == NULL )
+        {
+            os_errno = OS_STATUS_QUEUE_FULL;
+            return -1;
+        }
+
+        new->msg_prio = prio;
+        new->msg_stamp = stamp;
+        new->msg_size = size;
+        new->msg_state = _QUEUE_MSG_QUEUED;
+        memcpy(_QUEUE_MSG_DATA(new), data, size);
+
+        mpmc_ring_publish_put(_QUEUE_MPMC(queue_id), new);
+        if( _os_queue_signal(queue_id, 1) < 0 ) 
+        {
+            os_errno = OS_STATUS_EERR;
+            return -1;
+        }
+        return 0;
+    }
+
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        rec = _os_queue_var_alloc(queue_id, size);
+        if( rec == NULL )
+        {
+            os_errno = OS_STATUS_QUEUE_FULL;
+            return -1;
+        }
+
+        rec->msg_stamp = stamp;
+        rec->msg_size = size;
+        memcpy(_QUEUE_VAR_DATA(rec), data, size);
+
+        atomic_store_release(&rec->rec_state, _QUEUE_REC_READY);
+        if( _os_queue_signal(queue_id, 1) < 0 ) 
+        {
+            os_errno = OS_STATUS_EERR;
+            return -1;
+        }
+        return 0;
+    }
+
+    /* Get Message From Message Queue */
+    _QUEUE_LOCK(queue_id, level);
+    new = pool_alloc_elem( &os_queue_table[queue_id].msg_pool.pool);
+    if( new != NULL )
+        os_queue_table[queue_id].msg_pool.allocated++;    // increase the allocated buffers
+    _QUEUE_UNLOCK(queue_id, level);
+    if( (new == NULL) && _QUEUE_IS_OVERWRITE(queue_id) )
+        new = _os_queue_recycle_msg(queue_id);
+    if( new == NULL )
+    {
+        os_errno = OS_STATUS_QUEUE_FULL;
+        return -1;
+    }
+
+    /** Write the buffer pointer to the queue.  If an error occurred, report it
+     ** with the corresponding SB status code.
+     */
+    new->msg_prio = prio;
+    new->msg_stamp = stamp;
+    new->msg_deadline = _QUEUE_DEADLINE(prio);
+    new->msg_size = size;
+    memcpy(_QUEUE_MSG_DATA(new), data, size);
+
+    _QUEUE_LOCK(queue_id, level);
+    _os_queue_enqueue(queue_id, new);
+    _QUEUE_UNLOCK(queue_id, level);
+
+    if( _os_queue_signal(queue_id, 1) < 0 )
+    {
+        os_errno = OS_STATUS_EERR;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Stores a message as _os_queue_store() does, waiting for room according to
+ * the queue blocking mode and 'timeout' while the queue is full.
+ */
+static int _os_queue_store_wait(uint32_t queue_id, void *data, uint32_t size, 
+        uint32_t prio, int32_t timeout)
+{
+    uint32_t start;
+    int32_t left;
+    int ret;
+
+    start = _os_queue_stamp();
+    ret = _os_queue_store(queue_id, data, size, prio);
+    if( (ret < 0) && (os_errno != OS_STATUS_QUEUE_FULL) )
+        return -1;
+    if( ret == 0 )
+        return 0;
+
+    if( (timeout <= 0) && 
+            (os_queue_table[queue_id].is_blocking == OS_NONBLOCKING) )
+    {
+        _os_queue_stats_drop(queue_id, 1);
+        os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+    }
+
+    if( os_queue_table[queue_id].space_created == FALSE )
+    {
+        WLOCK();
+        if( os_queue_table[queue_id].space_created == FALSE )
+        {
+            if( OS_CountSemCreate(&os_queue_table[queue_id].space_semid, 0, 0) < 0 )
+            {
+                WUNLOCK();
+                os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+            }
+            os_queue_table[queue_id].space_created = TRUE;
+        }
+        WUNLOCK();
+    }
+
+    /*  Register as a waiter before trying again so no freed slot is missed.
+     *  Units given for slots another producer took just cause another try */
+    atomic_add32(os_queue_table[queue_id].put_waiting, 1);
+    for(;;)
+    {
+        atomic_mb();
+        ret = _os_queue_store(queue_id, data, size, prio);
+        if( (ret == 0) || (os_errno != OS_STATUS_QUEUE_FULL) )
+            break;
+
+        if( timeout > 0 )
+        {
+            left = timeout - (int32_t)((_os_queue_stamp() - start) / 1000);
+            if( left <= 0 )
+            {
+                os_errno = OS_STATUS_TIMEOUT;
+                break;
+            }
+            ret = OS_CountSemTimedWait(os_queue_table[queue_id].space_semid, left);
+        }
+        else
+            ret = OS_CountSemTake(os_queue_table[queue_id].space_semid);
+
+        if( (ret < 0) && (os_errno != OS_STATUS_TIMEOUT) )
+        {
+            os_errno = OS_STATUS_EERR;
+            break;
+        }
+    }
+    atomic_add32(os_queue_table[queue_id].put_waiting, (uint32_t)-1);
+
+    if( ret < 0 )
+    {
+        if( os_errno == OS_STATUS_TIMEOUT )
+            _os_queue_stats_drop(queue_id, 1);
+        return -1;
+    }
+
+    return 0;
+}
+
+#if defined(CONFIG_LINUX)
+/*
+ * Takes a queue entry for the shared queue region 'shm' mapped by this
+ * process. The entry uses the semaphores of the region, which are
+ * initialized by the 'owner' of the region.
+ */
+static int _os_queue_shm_bind(uint32_t *queue_id, struct os_queue_shm *shm, 
+        uint32_t flags, int owner)
+{
+    OS_queue_record_t *queue;
+    uint32_t possible_qid;
+    int ret;
+
+    WLOCK();
+    {
+        for(possible_qid = 0; possible_qid < OS_MAX_QUEUES; possible_qid++)
+        {
+            if (os_queue_table[possible_qid].free == TRUE)
+                break;
+        }
+
+        if( possible_qid >= OS_MAX_QUEUES )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        /*  The semaphores left by a private queue are not needed   */
+        queue = &os_queue_table[possible_qid];
+        if( queue->sem_created )
+            OS_CountSemDelete(queue->semid);
+        if( queue->space_created )
+            OS_CountSemDelete(queue->space_semid);
+        queue->sem_created = FALSE;
+        queue->space_created = FALSE;
+
+        if( owner )
+            ret = OS_CountSemCreateShared(&queue->semid, &shm->msgs_sem, 0);
+        else
+            ret = OS_CountSemAttachShared(&queue->semid, &shm->msgs_sem);
+        if( ret < 0 )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        }
+
+        if( owner )
+            ret = OS_CountSemCreateShared(&queue->space_semid, &shm->space_sem, 0);
+        else
+            ret = OS_CountSemAttachShared(&queue->space_semid, &shm->space_sem);
+        if( ret < 0 )
+        {
+            OS_CountSemDelete(queue->semid);
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        }
+
+        queue->sem_created = TRUE;
+        queue->space_created = TRUE;
+
+        /* set the ID free to false to prevent other tasks from grabbing it */
+        queue->free = FALSE;
+    }
+    WUNLOCK();
+
+    pool_init( &queue->msg_pool.pool );
+    queue->mpmc_ring = &shm->ring;
+    queue->put_waiting = &shm->put_waiting;
+    queue->shm = shm;
+    queue->shm_owner = owner;
+
+    *queue_id = possible_qid;
+
+    WLOCK();
+    {
+        queue->mul_Creator = OS_TaskGetId();
+        queue->is_blocking = (flags & OS_NONBLOCKING) ? OS_NONBLOCKING : OS_BLOCKING;
+        queue->flags = OS_QUEUE_MPMC | flags;
+        queue->data_size = shm->data_size;
+        queue->msg_pool.allocated = 0;
+        memset(&queue->put_stats, 0, sizeof(struct os_queue_put_stats));
+        memset(&queue->get_stats, 0, sizeof(struct os_queue_get_stats));
+
+        /*  Stats   */
+        STATS_CREAT_QUEUE();
+    }
+    WUNLOCK();
+
+    return 0;
+}
+
+/*
+ * Gives back the entry of a shared queue and unmaps its region. The owner
+ * also removes its name, the processes still attached keep using it.
+ */
+static int _os_queue_shm_unbind(uint32_t queue_id)
+{
+    OS_queue_record_t *queue = &os_queue_table[queue_id];
+    struct os_queue_shm *shm = queue->shm;
+
+    WLOCK();
+    {
+        OS_CountSemDelete(queue->semid);
+        OS_CountSemDelete(queue->space_semid);
+        queue->sem_created = FALSE;
+        queue->space_created = FALSE;
+        queue->mpmc_ring = &queue->mpmc;
+        queue->put_waiting = &queue->put_waiters;
+        queue->shm = NULL;
+        queue->flags = 0;
+        queue->free = TRUE;
+        queue->mul_Creator = UNINITIALIZED;
+
+        /*  Stats   */
+        STATS_DEL_QUEUE();
+    }
+    WUNLOCK();
+
+    if( queue->shm_owner )
+        shm_unlink(shm->name);
+    if( munmap(shm, shm->size) < 0 )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    return 0;
+}
+
+/*  Copies 'n' bytes at the 'pos' counter of the recording ring */
+static void _os_queue_rec_copy(uint32_t pos, const void *src, uint32_t n)
+{
+    uint32_t off = pos & (os_queue_rec.size - 1);
+    uint32_t first = os_queue_rec.size - off;
+
+    if( first >= n )
+        memcpy(os_queue_rec.buffer + off, src, n);
+    else
+    {
+        memcpy(os_queue_rec.buffer + off, src, first);
+        memcpy(os_queue_rec.buffer, (const uint8_t*)src + first, n - first);
+    }
+}
+
+/*
+ * Appends the message put on the queue to the recording ring, or counts it
+ * as lost when it does not fit. The writer thread is never waited for.
+ */
+static void _os_queue_record(uint32_t queue_id, void *data, uint32_t size, uint32_t prio)
+{
+    OS_queue_log_entry_t entry;
+    OS_time_t t;
+    uint32_t level;
+    uint32_t head;
+
+    spin_lock(&os_queue_rec.lock, level);
+    {
+        head = os_queue_rec.head;
+        if( !os_queue_rec.active )
+            ;
+        else if( sizeof(entry) + size > 
+                os_queue_rec.size - (head - atomic_load_acquire(&os_queue_rec.tail)) )
+            os_queue_rec.lost++;
+        else
+        {
+            OS_GetTimeSinceBoot(&t);
+            entry.mul_Seconds = t.mul_Seconds;
+            entry.mul_MicroSeconds = t.mul_MicroSeconds;
+            entry.mul_QueueId = queue_id;
+            entry.mul_Prio = prio;
+            entry.mul_Size = size;
+
+            _os_queue_rec_copy(head, &entry, sizeof(entry));
+            _os_queue_rec_copy(head + sizeof(entry), data, size);
+            atomic_store_release(&os_queue_rec.head, head + sizeof(entry) + size);
+        }
+    }
+    spin_unlock(&os_queue_rec.lock, level);
+}
+
+/*  Writes 'n' bytes to the log file    */
+static int _os_queue_rec_write(const void *data, uint32_t n)
+{
+    ssize_t ret;
+
+    while( n )
+    {
+        ret = write(os_queue_rec.fd, data, n);
+        if( ret < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            return -1;
+        }
+        data = (const uint8_t*)data + ret;
+        n -= ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Writer task of the recording. It writes the ring to the log file until
+ * the recording is stopped and the ring is empty.
+ */
+static void _os_queue_rec_writer(void)
+{
+    uint32_t head, tail, off, n;
+
+    for(;;)
+    {
+        head = atomic_load_acquire(&os_queue_rec.head);
+        tail = os_queue_rec.tail;
+
+        if( head == tail )
+        {
+            if( !atomic_load_acquire(&os_queue_rec.running) )
+                break;
+            OS_Sleep(_QUEUE_REC_PERIOD);
+            continue;
+        }
+
+        /*  Up to the end of the buffer, the rest on the next round */
+        off = tail & (os_queue_rec.size - 1);
+        n = head - tail;
+        if( n > os_queue_rec.size - off )
+            n = os_queue_rec.size - off;
+
+        if( !os_queue_rec.failed && (_os_queue_rec_write(os_queue_rec.buffer + off, n) < 0) )
+            os_queue_rec.failed = TRUE;
+
+        atomic_store_release(&os_queue_rec.tail, tail + n);
+    }
+
+    OS_BinSemGive(os_queue_rec.done_semid);
+    OS_TaskExit();
+}
+#endif
+
+static void _os_queue_init(void)
+{
+    int i;
+
+    STATS_INIT_QUEUE();
+
+    /* Initialize Message Queue Table */
+
+    for(i = 0; i < OS_MAX_QUEUES; i++)
+    {
+        os_queue_table[i].free        = TRUE;
+        os_queue_table[i].mul_Creator     = UNINITIALIZED;
+        os_queue_table[i].is_blocking = UNINITIALIZED;
+        os_queue_table[i].flags       = 0;
+        os_queue_table[i].select_mask = 0;
+        spin_init(&os_queue_table[i].lock);
+
+        _os_queue_init_msg_list(&os_queue_table[i].msg_list);
+        os_queue_table[i].msg_heap.count = 0;
+        pool_init(&os_queue_table[i].msg_pool.pool);
+
+        /*  The semaphores are created as the queues are, so the unused
+         *  entries do not hold any   */
+        os_queue_table[i].put_waiters   = 0;
+        os_queue_table[i].put_waiting   = &os_queue_table[i].put_waiters;
+        os_queue_table[i].mpmc_ring     = &os_queue_table[i].mpmc;
+        os_queue_table[i].shm           = NULL;
+        os_queue_table[i].sem_created   = FALSE;
+        os_queue_table[i].space_created = FALSE;
+    }
+
+    for(i = 0; i < OS_MAX_QUEUE_SELECTS; i++)
+    {
+        os_queue_select_table[i].free    = TRUE;
+        os_queue_select_table[i].created = FALSE;
+    }
+
+#if defined(CONFIG_LINUX)
+    spin_init(&os_queue_rec.lock);
+    os_queue_rec.active = FALSE;
+    os_queue_rec.running = FALSE;
+#endif
+
+    INIT_THREAD_MUTEX();
+}
+
+
+/********************************* PUBLIC  INTERFACE    */
+
+/****************************************************************************************
+  MESSAGE QUEUE API
+ ****************************************************************************************/
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueCreate
+ *  Description:  This function creates a message queue.
+ *  Parameters:
+ *      - queue_id:     This is the queue identifier to be returned
+ *      - buffer:       Memory where messages and their descriptors are stored
+ *      - buffer_size:  Size of 'buffer', see OS_QUEUE_BUFFER_SIZE()
+ *      - queue_depth:  This is the depth of the queue
+ *      - data_size:    This is the size of the data to be stored in the queue
+ *      - flags:        OS_NONBLOCKING and one of OS_QUEUE_SPSC, OS_QUEUE_MPMC,
+ *                      OS_QUEUE_VARIABLE, OS_QUEUE_OVERWRITE or
+ *                      OS_QUEUE_DEADLINE (optionally OS_QUEUE_DROP_EXPIRED)
+ *  Return:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when there is not valid pointers passed as parameters
+ *      OS_STATUS_NAME_TOO_LONG when the queue name is too long
+ *      OS_STATUS_NO_FREE_IDS when there are no more identifiers for the queues
+ *      OS_STATUS_NAME_TAKEN when the 'queue_name' is already in use
+ *      OS_STATUS_EERR when any other error occurs
+ *
+ * =====================================================================================
+ */
+int OS_QueueCreate (
+        uint32_t *queue_id, 
+        char     *buffer,
+        uint32_t buffer_size,
+        uint32_t queue_depth, 
+        uint32_t data_size, 
+        uint32_t flags)
+{
+    uint32_t size_aligned;
+    uint32_t num_msgs;
+    uint32_t i;
+
+    ASSERT(queue_id);
+
+    _CHECK_QUEUE_INIT();
+
+    uint32_t possible_qid;
+
+    /*  Sanity checks   */
+    if ( queue_id == NULL )
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+    else if ( buffer == NULL )
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+    else if( (uintptr_t)buffer & 0x3 )
+    {
+        printf("%s:%d: Buffer not aligned (%p)\n", __func__, __LINE__, buffer);
+        os_return_minus_one_and_set_errno(OS_STATUS_ADDRESS_MISALIGNED);
+    }
+
+    if(queue_depth == 0 || data_size == 0)
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+    else if ( (buffer_size == 0) || (buffer_size < data_size) )
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    /*  Each message takes its descriptor plus the payload aligned to the
+     *  pointer size so it does not cause any memory trap. The queue holds
+     *  'queue_depth' messages as long as the buffer is large enough.
+     */
+    size_aligned = _QUEUE_MSG_HDR_SIZE + _QUEUE_ALIGN(data_size);
+    num_msgs = buffer_size / size_aligned;
+    if( num_msgs > queue_depth )
+        num_msgs = queue_depth;
+    if( (num_msgs == 0) && !(flags & OS_QUEUE_VARIABLE) )
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    if( (flags & ~(OS_NONBLOCKING | OS_QUEUE_OVERWRITE | OS_QUEUE_DEADLINE | 
+                    OS_QUEUE_DROP_EXPIRED | _QUEUE_MODES)) || 
+            ((flags & _QUEUE_MODES) & ((flags & _QUEUE_MODES) - 1)) ||
+            ((flags & OS_QUEUE_OVERWRITE) && (flags & (_QUEUE_MODES | OS_QUEUE_DEADLINE))) ||
+            ((flags & OS_QUEUE_DEADLINE) && (flags & _QUEUE_MODES)) ||
+            ((flags & OS_QUEUE_DROP_EXPIRED) && !(flags & OS_QUEUE_DEADLINE)) )
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    if( flags & OS_QUEUE_DEADLINE )
+    {
+        /*  The heap takes a pointer per message after the slots    */
+        num_msgs = buffer_size / (size_aligned + sizeof(msg_t *));
+        if( num_msgs > queue_depth )
+            num_msgs = queue_depth;
+        if( num_msgs == 0 )
+        {
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        }
+    }
+
+    if( flags & OS_QUEUE_VARIABLE )
+    {
+        /*  Messages take the room they need, the largest one shall fit */
+        if( _QUEUE_VAR_HDR_SIZE + _QUEUE_ALIGN(data_size) > 
+                (buffer_size & ~((uint32_t)sizeof(void *) - 1)) )
+        {
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        }
+    }
+
+    if( flags & OS_QUEUE_MPMC )
+    {
+        /*  Slots carry the ring sequence number and come in powers of two */
+        num_msgs = buffer_size / (MPMC_RING_HDR_SIZE + size_aligned);
+        if( num_msgs > queue_depth )
+            num_msgs = queue_depth;
+        while( num_msgs & (num_msgs - 1) )
+            num_msgs &= num_msgs - 1;
+        if( num_msgs < 2 )
+        {
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        }
+    }
+
+    /* we don't want to allow names too long*/
+    /* if truncated, two names might be the same */
+
+
+    /* Check Parameters */
+    WLOCK();
+    {
+        for(possible_qid = 0; possible_qid < OS_MAX_QUEUES; possible_qid++)
+        {
+            if (os_queue_table[possible_qid].free == TRUE)
+                break;
+        }
+
+        if( possible_qid >= OS_MAX_QUEUES || os_queue_table[possible_qid].free != TRUE)
+        {
+            WUNLOCK();
+
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
+
+        if( os_queue_table[possible_qid].sem_created == FALSE )
+        {
+            if( OS_CountSemCreate(&os_queue_table[possible_qid].semid, 0, 0) < 0 )
+            {
+                WUNLOCK();
+                os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+            }
+            os_queue_table[possible_qid].sem_created = TRUE;
+        }
+
+        /* set the ID free to false to prevent other tasks from grabbing it */
+        os_queue_table[possible_qid].free = FALSE;   
+    }
+    WUNLOCK();
+
+    /*
+     ** Create the message queue.
+     */
+    if( flags & OS_QUEUE_SPSC )
+    {
+        pool_init( &os_queue_table[possible_qid].msg_pool.pool );
+        spsc_ring_init( &os_queue_table[possible_qid].ring, 
+                (uint8_t*)buffer, size_aligned, num_msgs);
+        for( i = 0; i < num_msgs; i++ )
+            ((msg_t *)(buffer + i * size_aligned))->msg_state = _QUEUE_MSG_FREE;
+    }
+    else if( flags & OS_QUEUE_MPMC )
+    {
+        pool_init( &os_queue_table[possible_qid].msg_pool.pool );
+        os_queue_table[possible_qid].mpmc_ring = &os_queue_table[possible_qid].mpmc;
+        mpmc_ring_init( &os_queue_table[possible_qid].mpmc, 
+                (uint8_t*)buffer, MPMC_RING_HDR_SIZE + size_aligned, num_msgs);
+        for( i = 0; i < num_msgs; i++ )
+            ((msg_t *)MPMC_RING_ELEM(mpmc_ring_slot(&os_queue_table[possible_qid].mpmc, i)))->
+                msg_state = _QUEUE_MSG_FREE;
+    }
+    else if( flags & OS_QUEUE_VARIABLE )
+    {
+        pool_init( &os_queue_table[possible_qid].msg_pool.pool );
+        byte_ring_init( &os_queue_table[possible_qid].bytes, 
+                (uint8_t*)buffer, buffer_size);
+    }
+    else
+    {
+        pool_init_memory( &os_queue_table[possible_qid].msg_pool.pool, 
+                (uint8_t*)buffer, num_msgs * size_aligned, size_aligned);
+        for( i = 0; i < num_msgs; i++ )
+            ((msg_t *)(buffer + i * size_aligned))->msg_state = _QUEUE_MSG_FREE;
+        os_queue_table[possible_qid].msg_heap.msgs = 
+            (msg_t **)(buffer + num_msgs * size_aligned);
+        os_queue_table[possible_qid].msg_heap.count = 0;
+        os_queue_table[possible_qid].msg_heap.epoch = _os_queue_clock();
+    }
+
+    /*
+     ** If the operation failed, report the error */
+
+    /* Set the name of the queue, and the mul_Creator as well */
+
+    *queue_id = possible_qid;
+
+    WLOCK();
+    {
+        os_queue_table[*queue_id].free = FALSE;
+        os_queue_table[*queue_id].mul_Creator = OS_TaskGetId();
+        os_queue_table[*queue_id].is_blocking = (flags & OS_NONBLOCKING) ? OS_NONBLOCKING : OS_BLOCKING;
+        os_queue_table[*queue_id].flags = flags;
+        os_queue_table[*queue_id].data_size = size_aligned - _QUEUE_MSG_HDR_SIZE;
+        os_queue_table[*queue_id].msg_pool.allocated = 0;    // clear the allocated buffers
+        memset(&os_queue_table[*queue_id].put_stats, 0, sizeof(struct os_queue_put_stats));
+        memset(&os_queue_table[*queue_id].get_stats, 0, sizeof(struct os_queue_get_stats));
+
+        /*  Stats   */
+        STATS_CREAT_QUEUE();
+    }
+    WUNLOCK();
+
+    return 0;
+
+} /* end OS_QueueCreate */
+
+#if defined(CONFIG_LINUX)
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueCreateShared
+ *  Description:  This function creates a multi-producer/multi-consumer
+ *  message queue in a named shared memory region, so other processes can
+ *  attach to it.
+ *  Parameters:
+ *      - queue_id:     queue identifier
+ *      - name:         shared memory object name, as for shm_open()
+ *      - queue_depth:  maximum number of messages, rounded up to a power of
+ *                      two
+ *      - data_size:    maximum size of the messages
+ *      - flags:        OS_NONBLOCKING
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any parameter is not valid
+ *      OS_STATUS_EBUSY when a shared memory object with that name exists
+ *      OS_STATUS_NO_FREE_IDS when there is no free queue entry
+ *      OS_STATUS_EERR when the region can not be created
+ * =====================================================================================
+ */
+int OS_QueueCreateShared (
+        uint32_t *queue_id, 
+        const char *name,
+        uint32_t queue_depth, 
+        uint32_t data_size, 
+        uint32_t flags)
+{
+    struct os_queue_shm *shm;
+    uint32_t slot_size, num_msgs, size;
+    int fd;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if( (queue_id == NULL) || (name == NULL) || (strlen(name) >= OS_QUEUE_NAME_MAX) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( (queue_depth == 0) || (queue_depth > 0x80000000UL) || (data_size == 0) || 
+            (flags & ~OS_NONBLOCKING) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    /*  Slots carry the ring sequence number and come in powers of two */
+    slot_size = MPMC_RING_HDR_SIZE + _QUEUE_MSG_HDR_SIZE + _QUEUE_ALIGN(data_size);
+    for( num_msgs = 2; num_msgs < queue_depth; num_msgs <<= 1 );
+    if( num_msgs > (0xffffffffUL - sizeof(struct os_queue_shm)) / slot_size )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    size = sizeof(struct os_queue_shm) + num_msgs * slot_size;
+
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if( fd < 0 )
+        os_return_minus_one_and_set_errno((errno == EEXIST) ? OS_STATUS_EBUSY : OS_STATUS_EERR);
+
+    shm = MAP_FAILED;
+    if( ftruncate(fd, size) == 0 )
+        shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if( shm == MAP_FAILED )
+    {
+        shm_unlink(name);
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    shm->size = size;
+    shm->data_size = _QUEUE_ALIGN(data_size);
+    shm->put_waiting = 0;
+    strcpy(shm->name, name);
+    mpmc_ring_init( &shm->ring, (uint8_t *)(shm + 1), slot_size, num_msgs);
+
+    if( _os_queue_shm_bind(queue_id, shm, flags, TRUE) < 0 )
+    {
+        munmap(shm, size);
+        shm_unlink(name);
+        return -1;
+    }
+
+    /*  The region is complete, other processes may attach to it now  */
+    atomic_store_release(&shm->magic, _QUEUE_SHM_MAGIC);
+
+    return 0;
+
+} /* end OS_QueueCreateShared */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueAttach
+ *  Description:  This function gives access to the queue another process
+ *  created with OS_QueueCreateShared().
+ *  Parameters:
+ *      - queue_id:     queue identifier
+ *      - name:         name the queue was created with
+ *      - flags:        OS_NONBLOCKING
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any parameter is not valid or there is no
+ *      queue with that name
+ *      OS_STATUS_EBUSY when the queue is still being created
+ *      OS_STATUS_NO_FREE_IDS when there is no free queue entry
+ *      OS_STATUS_EERR when the region can not be mapped
+ * =====================================================================================
+ */
+int OS_QueueAttach (uint32_t *queue_id, const char *name, uint32_t flags)
+{
+    struct os_queue_shm *shm;
+    struct stat st;
+    int fd;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if( (queue_id == NULL) || (name == NULL) || (flags & ~OS_NONBLOCKING) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    fd = shm_open(name, O_RDWR, 0);
+    if( fd < 0 )
+        os_return_minus_one_and_set_errno((errno == ENOENT) ? OS_STATUS_EINVAL : OS_STATUS_EERR);
+
+    if( (fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(struct os_queue_shm)) )
+    {
+        close(fd);
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    }
+
+    shm = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if( shm == MAP_FAILED )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    if( (atomic_load_acquire(&shm->magic) != _QUEUE_SHM_MAGIC) || 
+            (shm->size != (uint32_t)st.st_size) )
+    {
+        munmap(shm, st.st_size);
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    }
+
+    if( _os_queue_shm_bind(queue_id, shm, flags, FALSE) < 0 )
+    {
+        munmap(shm, st.st_size);
+        return -1;
+    }
+
+    return 0;
+
+} /* end OS_QueueAttach */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueRecordStart
+ *  Description:  This function starts recording the messages put on the
+ *  queues into a log file, through a background writer task.
+ *  Parameters:
+ *      - path:         path of the log file
+ *      - buffer:       memory buffering the log
+ *      - buffer_size:  size of 'buffer'
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any parameter is not valid
+ *      OS_STATUS_EBUSY when a recording is already running
+ *      OS_STATUS_EERR when the log file or the writer can not be created
+ * =====================================================================================
+ */
+int OS_QueueRecordStart (const char *path, void *buffer, uint32_t buffer_size)
+{
+    OS_queue_log_t log;
+    int fd;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if( (path == NULL) || (buffer == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( buffer_size <= sizeof(OS_queue_log_entry_t) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    WLOCK();
+    if( os_queue_rec.running )
+    {
+        WUNLOCK();
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if( fd < 0 )
+    {
+        WUNLOCK();
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    os_queue_rec.fd = fd;
+    os_queue_rec.buffer = buffer;
+    os_queue_rec.size = 1UL << bit_fls32(buffer_size);
+    os_queue_rec.head = 0;
+    os_queue_rec.tail = 0;
+    os_queue_rec.lost = 0;
+    os_queue_rec.failed = FALSE;
+    os_queue_rec.running = TRUE;
+
+    log.mul_Magic = OS_QUEUE_LOG_MAGIC;
+    log.mul_Version = OS_QUEUE_LOG_VERSION;
+    if( (_os_queue_rec_write(&log, sizeof(log)) < 0) ||
+            (OS_BinSemCreate(&os_queue_rec.done_semid, 0, 0) < 0) )
+    {
+        os_queue_rec.running = FALSE;
+        close(fd);
+        WUNLOCK();
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    if( OS_TaskCreate(&os_queue_rec.writer, (void*)_os_queue_rec_writer, 
+                _QUEUE_REC_STACK, _QUEUE_REC_PRIO, 0, NULL) < 0 )
+    {
+        os_queue_rec.running = FALSE;
+        OS_BinSemDelete(os_queue_rec.done_semid);
+        close(fd);
+        WUNLOCK();
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    atomic_store_release(&os_queue_rec.active, TRUE);
+    WUNLOCK();
+
+    return 0;
+
+} /* end OS_QueueRecordStart */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueRecordStop
+ *  Description:  This function stops recording the messages put on the
+ *  queues once the buffered log is written.
+ *  Parameters:
+ *      - lost:     number of messages not recorded, unless NULL
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when there is no recording running
+ *      OS_STATUS_EERR when some of the log could not be written
+ * =====================================================================================
+ */
+int OS_QueueRecordStop (uint32_t *lost)
+{
+    uint32_t level;
+    int ret;
+
+    _CHECK_QUEUE_INIT();
+
+    WLOCK();
+    if( !os_queue_rec.running )
+    {
+        WUNLOCK();
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    /*  No task is appending once the lock is taken with 'active' cleared */
+    os_queue_rec.active = FALSE;
+    spin_lock(&os_queue_rec.lock, level);
+    spin_unlock(&os_queue_rec.lock, level);
+
+    atomic_store_release(&os_queue_rec.running, FALSE);
+    OS_BinSemTake(os_queue_rec.done_semid);
+    OS_BinSemDelete(os_queue_rec.done_semid);
+
+    ret = close(os_queue_rec.fd);
+    if( lost != NULL )
+        *lost = os_queue_rec.lost;
+    WUNLOCK();
+
+    if( os_queue_rec.failed || (ret < 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    return 0;
+
+} /* end OS_QueueRecordStop */
+#endif
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueDelete
+ *  Description:  This function deletes the queue object referenced by
+ *  'queue_id'.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'queue_id' is not valid
+ *      OS_STATUS_EERR when any other error occurs
+ *
+ * NOTE: This function is only allow in the non-LOCAL resource allocation mode,
+ * which can be seleceted during OSAL configuraiton.
+ * =====================================================================================
+ */
+int OS_QueueDelete (uint32_t queue_id)
+{
+    _CHECK_QUEUE_INIT();
+
+#if defined (CONFIG_OS_STATIC_RESOURCE_ALLOCATION)
+    os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+#else
+    /* Check to see if the queue_id given is valid */
+
+    if (queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+#if defined(CONFIG_LINUX)
+    /*  Other processes may still use the messages of a shared queue    */
+    if( _QUEUE_IS_SHARED(queue_id) )
+        return _os_queue_shm_unbind(queue_id);
+#endif
+
+    /* Try to delete the queue */
+    if( os_queue_table[queue_id].msg_pool.allocated )
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    if( _QUEUE_IS_SPSC(queue_id) && spsc_ring_avail(&os_queue_table[queue_id].ring, 1) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    if( _QUEUE_IS_MPMC(queue_id) && 
+            (_QUEUE_MPMC(queue_id)->enqueue_pos != _QUEUE_MPMC(queue_id)->dequeue_pos) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    if( _QUEUE_IS_VAR(queue_id) && os_queue_table[queue_id].bytes.records )
+        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+
+    /* 
+     * Now that the queue is deleted, remove its "presence"
+     * in os_queue_table
+     */
+    WLOCK();
+    {
+        pool_init(&os_queue_table[queue_id].msg_pool.pool);
+        os_queue_table[queue_id].flags = 0;
+        os_queue_table[queue_id].free = TRUE;
+        os_queue_table[queue_id].mul_Creator = UNINITIALIZED;
+
+        /*  Stats   */
+        STATS_DEL_QUEUE();
+    }
+    WUNLOCK();
+
+    return 0;
+#endif
+
+} /* end OS_QueueDelete */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueGet
+ *  Description:  This function retrieves data items from the referenced queue.
+ *  Parameters:
+ *      - queue_id:     queue identifier
+ *      - data:         data retrieved
+ *      - size:         maximum size of the data element being gathered
+ *      - size_copied:  actual size of the data retrieved
+ *      - timeout:      time out
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the queue identifier is not valid
+ *      OS_STATUS_EINVAL when any of the pointer parameters are not valid
+ *      OS_STATUS_QUEUE_EMPTY when the queue is empty
+ *      OS_STATUS_TIMEOUT when the timeout expires
+ *      OS_STATUS_EBUSY when the head of an OS_QUEUE_SPSC queue is borrowed
+ * =====================================================================================
+ */
+int OS_QueueGet (
+        uint32_t queue_id, 
+        void *data, 
+        uint32_t size, 
+        size_t *size_copied, 
+        int32_t timeout)
+{
+    msg_t *msg = NULL;
+    vmsg_t *rec;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+    {
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+    else
+    {
+        if( (data == NULL) || (size_copied == NULL) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        msg = _os_queue_spsc_wait(queue_id, timeout);
+        if( msg == NULL ) return -1;
+
+        *size_copied = msg->msg_size;
+        memcpy(data, _QUEUE_MSG_DATA(msg), msg->msg_size);
+        spsc_ring_consume( &os_queue_table[queue_id].ring, 1 );
+        _os_queue_space_signal(queue_id, 1);
+        return 0;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        msg = _os_queue_mpmc_wait(queue_id, timeout);
+        if( msg == NULL ) return -1;
+
+        *size_copied = msg->msg_size;
+        memcpy(data, _QUEUE_MSG_DATA(msg), msg->msg_size);
+        msg->msg_state = _QUEUE_MSG_FREE;
+        mpmc_ring_publish_get( _QUEUE_MPMC(queue_id), msg );
+        _os_queue_space_signal(queue_id, 1);
+        return 0;
+    }
+
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        rec = _os_queue_var_wait(queue_id, timeout);
+        if( rec == NULL ) return -1;
+
+        *size_copied = rec->msg_size;
+        memcpy(data, _QUEUE_VAR_DATA(rec), rec->msg_size);
+        _os_queue_var_free(queue_id, rec);
+        return 0;
+    }
+
+    msg = _os_queue_wait_msg(queue_id, timeout);
+    if( msg == NULL ) return -1;
+
+    *size_copied = msg->msg_size;
+    memcpy(data, _QUEUE_MSG_DATA(msg), msg->msg_size);
+    _os_queue_free_msg(queue_id, msg);
+
+    return 0;
+
+}/* end OS_QueueGet */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueuePut
+ *  Description:  This function stores a data in the queue referenced by
+ *  'queue_id'.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *      - data:     pointer to the data to be put
+ *      - size:     data size
+ *      - prio:     message priority.
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'data' pointer is not valid
+ *      OS_STATUS_EINVAL when the 'queue_id' is not valid
+ *      OS_STATUS_QUEUE_FULL when the queue is already full of data
+ *      OS_STATUS_EERR when any other error occurrs.
+ * =====================================================================================
+ */
+int OS_QueuePut (uint32_t queue_id, void *data, uint32_t size, uint32_t prio)
+{
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if (data == NULL)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if(size == 0)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if(size > os_queue_table[queue_id].data_size)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _os_queue_store(queue_id, data, size, prio) < 0 )
+    {
+        if( os_errno == OS_STATUS_QUEUE_FULL )
+            _os_queue_stats_drop(queue_id, 1);
+        return -1;
+    }
+
+#if defined(CONFIG_LINUX)
+    if( os_queue_rec.active )
+        _os_queue_record(queue_id, data, size, prio);
+#endif
+
+    return 0;
+
+}/* end OS_QueuePut */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueuePutTimed
+ *  Description:  This function stores a data in the queue referenced by
+ *  'queue_id', waiting for room while the queue is full.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *      - data:     pointer to the data to be put
+ *      - size:     data size
+ *      - prio:     message priority.
+ *      - timeout:  time out
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'data' pointer is not valid
+ *      OS_STATUS_EINVAL when the 'queue_id' is not valid
+ *      OS_STATUS_QUEUE_FULL when the queue is full and the call shall not wait
+ *      OS_STATUS_TIMEOUT when the timeout expires
+ *      OS_STATUS_EERR when any other error occurrs.
+ * =====================================================================================
+ */
+int OS_QueuePutTimed (
+        uint32_t queue_id, 
+        void *data, 
+        uint32_t size, 
+        uint32_t prio, 
+        int32_t timeout)
+{
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if (data == NULL)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if(size == 0)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if(size > os_queue_table[queue_id].data_size)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _os_queue_store_wait(queue_id, data, size, prio, timeout) < 0 )
+        return -1;
+
+#if defined(CONFIG_LINUX)
+    if( os_queue_rec.active )
+        _os_queue_record(queue_id, data, size, prio);
+#endif
+
+    return 0;
+
+}/* end OS_QueuePutTimed */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueuePutMany
+ *  Description:  This function stores up to 'count' messages with the same
+ *  priority in the queue referenced by 'queue_id' in a single operation.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *      - data:     array of pointers to the data to be put
+ *      - size:     array of data sizes
+ *      - count:    number of messages in 'data'
+ *      - prio:     priority of the messages.
+ *      - put:      number of messages actually stored
+ *  Returns:
+ *      0 when at least one message is stored
+ *      OS_STATUS_EINVAL when any of the parameters is not valid
+ *      OS_STATUS_QUEUE_FULL when the queue is already full of data
+ *      OS_STATUS_EERR when any other error occurrs.
+ * =====================================================================================
+ */
+int OS_QueuePutMany (uint32_t queue_id, void *data[], uint32_t size[], 
+        uint32_t count, uint32_t prio, uint32_t *put)
+{
+    uint32_t stamp;
+    struct s_pool *pool;
+    struct s_list_head msgs;
+    void *slots[_QUEUE_BATCH];
+    uint32_t i, n, want, skip, stored;
+    int32_t level;
+    msg_t *new;
+    vmsg_t *rec;
+
+    _CHECK_QUEUE_INIT();
+
+    stamp = _os_queue_stamp();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( (data == NULL) || (size == NULL) || (put == NULL) || (count == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    for( i = 0; i < count; i++ )
+    {
+        if( (data[i] == NULL) || (size[i] == 0) || 
+                (size[i] > os_queue_table[queue_id].data_size) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    }
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        /*  All the slots are handed to the consumer at once    */
+        stored = spsc_ring_free(&os_queue_table[queue_id].ring, count);
+        if( stored > count ) stored = count;
+
+        *put = stored;
+        if( stored < count ) _os_queue_stats_drop(queue_id, count - stored);
+        if( stored == 0 ) os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+
+        for( i = 0; i < stored; i++ )
+        {
+            new = spsc_ring_tail_slot(&os_queue_table[queue_id].ring, i);
+            new->msg_prio = prio;
+            new->msg_stamp = stamp;
+            new->msg_size = size[i];
+            new->msg_state = _QUEUE_MSG_QUEUED;
+            memcpy(_QUEUE_MSG_DATA(new), data[i], new->msg_size);
+        }
+
+        spsc_ring_produce(&os_queue_table[queue_id].ring, stored);
+        _os_queue_signal(queue_id, stored);
+        return 0;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        for( stored = 0; stored < count; stored++ )
+        {
+            new = mpmc_ring_claim_put(_QUEUE_MPMC(queue_id));
+            if( new == NULL ) break;
+
+            new->msg_prio = prio;
+            new->msg_stamp = stamp;
+            new->msg_size = size[stored];
+            new->msg_state = _QUEUE_MSG_QUEUED;
+            memcpy(_QUEUE_MSG_DATA(new), data[stored], new->msg_size);
+            mpmc_ring_publish_put(_QUEUE_MPMC(queue_id), new);
+        }
+
+        *put = stored;
+        if( stored < count ) _os_queue_stats_drop(queue_id, count - stored);
+        if( stored == 0 ) os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+
+        if( _os_queue_signal(queue_id, stored) < 0 ) 
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        return 0;
+    }
+
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        for( stored = 0; stored < count; stored++ )
+        {
+            rec = _os_queue_var_alloc(queue_id, size[stored]);
+            if( rec == NULL ) break;
+
+            rec->msg_stamp = stamp;
+            rec->msg_size = size[stored];
+            memcpy(_QUEUE_VAR_DATA(rec), data[stored], rec->msg_size);
+            atomic_store_release(&rec->rec_state, _QUEUE_REC_READY);
+        }
+
+        *put = stored;
+        if( stored < count ) _os_queue_stats_drop(queue_id, count - stored);
+        if( stored == 0 ) os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+
+        if( _os_queue_signal(queue_id, stored) < 0 ) 
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        return 0;
+    }
+
+    pool = &os_queue_table[queue_id].msg_pool.pool;
+
+    /*  A full OS_QUEUE_OVERWRITE queue only keeps the newest messages  */
+    skip = 0;
+    if( _QUEUE_IS_OVERWRITE(queue_id) && 
+            (count > pool->memory_area_size / pool->data_size) )
+        skip = count - pool->memory_area_size / pool->data_size;
+
+    /*  Fill the slots and chain them so they are queued at once    */
+    INIT_LIST_HEAD(&msgs);
+    for( stored = skip; stored < count; stored += n )
+    {
+        n = count - stored;
+        if( n > _QUEUE_BATCH ) n = _QUEUE_BATCH;
+
+        _QUEUE_LOCK(queue_id, level);
+        want = n;
+        n = pool_alloc_nelem(pool, slots, want);
+        os_queue_table[queue_id].msg_pool.allocated += n;
+        _QUEUE_UNLOCK(queue_id, level);
+
+        /*  The slots missing are taken from the messages already queued  */
+        if( _QUEUE_IS_OVERWRITE(queue_id) )
+        {
+            while( (n < want) && ((slots[n] = _os_queue_recycle_msg(queue_id)) != NULL) )
+                n++;
+        }
+
+        for( i = 0; i < n; i++ )
+        {
+            new = (msg_t *)slots[i];
+            new->msg_prio = prio;
+            new->msg_stamp = stamp;
+            new->msg_deadline = _QUEUE_DEADLINE(prio);
+            new->msg_size = size[stored + i];
+            new->msg_state = _QUEUE_MSG_QUEUED;
+            memcpy(_QUEUE_MSG_DATA(new), data[stored + i], new->msg_size);
+            list_add_tail(&new->list, &msgs);
+        }
+        if( n < _QUEUE_BATCH ) 
+        {
+            stored += n;
+            break;
+        }
+    }
+
+    if( skip > 0 )
+    {
+        if( stored == skip )
+            stored = 0;
+        else
+        {
+            /*  The messages skipped are queued and overwritten at once */
+            _os_queue_stats_add(queue_id, &os_queue_table[queue_id].put_stats.puts, skip);
+            _os_queue_stats_add(queue_id, &os_queue_table[queue_id].put_stats.overwrites, skip);
+        }
+    }
+
+    *put = stored;
+    if( stored < count ) _os_queue_stats_drop(queue_id, count - stored);
+    if( stored == 0 ) os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+
+    _QUEUE_LOCK(queue_id, level);
+    _os_queue_enqueue_msgs(queue_id, &msgs, prio);
+    _QUEUE_UNLOCK(queue_id, level);
+
+    if( _os_queue_signal(queue_id, stored - skip) < 0 ) 
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+
+    return 0;
+
+}/* end OS_QueuePutMany */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueGetMany
+ *  Description:  This function retrieves up to 'count' messages from the
+ *  referenced queue in a single operation. The call waits for the first
+ *  message as OS_QueueGet() does and then takes the messages already queued.
+ *  Parameters:
+ *      - queue_id:     queue identifier
+ *      - data:         array of buffers where the messages are copied
+ *      - size:         size of each of the buffers in 'data'
+ *      - size_copied:  array storing the bytes copied of each message
+ *      retrieved, the message being truncated to 'size' bytes
+ *      - count:        number of buffers in 'data'
+ *      - got:          number of messages retrieved
+ *      - timeout:      time out
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when any of the parameters is not valid
+ *      OS_STATUS_TIMEOUT when the timeout expires
+ *      OS_STATUS_EERR when no message could be retrieved
+ *      OS_STATUS_EBUSY when the head of an OS_QUEUE_SPSC queue is borrowed
+ * =====================================================================================
+ */
+int OS_QueueGetMany (
+        uint32_t queue_id, 
+        void *data[], 
+        uint32_t size, 
+        size_t size_copied[], 
+        uint32_t count,
+        uint32_t *got,
+        int32_t timeout)
+{
+    struct s_pool *pool;
+    void *slots[_QUEUE_BATCH];
+    uint32_t extra, n, i;
+    int32_t level;
+    int expired;
+    msg_t *msg;
+    vmsg_t *rec;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( (data == NULL) || (size_copied == NULL) || (got == NULL) || (count == 0) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    *got = 0;
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        msg = _os_queue_spsc_wait(queue_id, timeout);
+        if( msg == NULL ) return -1;
+
+        /*  All the slots read are given back to the producer at once   */
+        n = spsc_ring_avail(&os_queue_table[queue_id].ring, count);
+        if( n > count ) n = count;
+
+        for( i = 0; i < n; i++ )
+        {
+            msg = spsc_ring_head_slot(&os_queue_table[queue_id].ring, i);
+            if( i > 0 ) _os_queue_stats_get(queue_id, msg->msg_stamp);
+            size_copied[i] = (msg->msg_size < size) ? msg->msg_size : size;
+            memcpy(data[i], _QUEUE_MSG_DATA(msg), size_copied[i]);
+        }
+
+        spsc_ring_consume(&os_queue_table[queue_id].ring, n);
+        _os_queue_space_signal(queue_id, n);
+        *got = n;
+        return 0;
+    }
+
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        rec = _os_queue_var_wait(queue_id, timeout);
+        if( rec == NULL ) return -1;
+
+        extra = count - 1;
+        if( extra > 0 )
+        {
+            if( OS_CountSemTryTakeMany(os_queue_table[queue_id].semid, extra, &extra) < 0 )
+                extra = 0;
+        }
+
+        /*  Every unit taken stands for a message published in the ring */
+        for( n = 0; ; )
+        {
+            size_copied[n] = (rec->msg_size < size) ? rec->msg_size : size;
+            memcpy(data[n], _QUEUE_VAR_DATA(rec), size_copied[n]);
+            _os_queue_var_free(queue_id, rec);
+
+            if( ++n > extra ) break;
+            rec = _os_queue_var_get(queue_id);
+        }
+
+        *got = n;
+        return 0;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+        msg = _os_queue_mpmc_wait(queue_id, timeout);
+    else
+        msg = _os_queue_wait_msg(queue_id, timeout);
+    if( msg == NULL ) return -1;
+
+    /*  One unit of the semaphore was taken for the first message  */
+    extra = count - 1;
+    if( extra > 0 )
+    {
+        if( OS_CountSemTryTakeMany(os_queue_table[queue_id].semid, extra, &extra) < 0 )
+            extra = 0;
+    }
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        /*  Every unit taken stands for a message published in the ring */
+        for( n = 0; ; )
+        {
+            size_copied[n] = (msg->msg_size < size) ? msg->msg_size : size;
+            memcpy(data[n], _QUEUE_MSG_DATA(msg), size_copied[n]);
+            msg->msg_state = _QUEUE_MSG_FREE;
+            mpmc_ring_publish_get(_QUEUE_MPMC(queue_id), msg);
+
+            if( ++n > extra ) break;
+            msg = _os_queue_mpmc_get(queue_id);
+        }
+
+        _os_queue_space_signal(queue_id, n);
+        *got = n;
+        return 0;
+    }
+
+    pool = &os_queue_table[queue_id].msg_pool.pool;
+    for( n = 0; msg != NULL; )
+    {
+        size_copied[*got] = (msg->msg_size < size) ? msg->msg_size : size;
+        memcpy(data[*got], _QUEUE_MSG_DATA(msg), size_copied[*got]);
+        msg->msg_state = _QUEUE_MSG_FREE;
+        slots[n++] = msg;
+        (*got)++;
+
+        msg = NULL;
+        while( extra > 0 )
+        {
+            extra--;
+            _QUEUE_LOCK(queue_id, level);
+            msg = _os_queue_dequeue(queue_id);
+            expired = (msg != NULL) && _os_queue_expired(queue_id, msg);
+            _QUEUE_UNLOCK(queue_id, level);
+            if( !expired ) break;
+
+            _os_queue_drop_expired(queue_id, msg);
+            msg = NULL;
+        }
+        if( msg != NULL ) _os_queue_stats_get(queue_id, msg->msg_stamp);
+
+        if( (n == _QUEUE_BATCH) || (msg == NULL) )
+        {
+            _QUEUE_LOCK(queue_id, level);
+            pool_free_nelem(pool, slots, n);
+            os_queue_table[queue_id].msg_pool.allocated -= n;
+            _QUEUE_UNLOCK(queue_id, level);
+            _os_queue_space_signal(queue_id, n);
+            n = 0;
+        }
+    }
+
+    /*  Give back the units taken for messages that were not there  */
+    for( i = 0; i < extra; i++ )
+        OS_CountSemGive(os_queue_table[queue_id].semid);
+
+    return 0;
+
+}/* end OS_QueueGetMany */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueReserve
+ *  Description:  This function reserves a free slot of the queue referenced
+ *  by 'queue_id' so the producer can write the message in place.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *      - data:     pointer to the reserved slot payload
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'data' pointer is not valid
+ *      OS_STATUS_EINVAL when the 'queue_id' is not valid
+ *      OS_STATUS_QUEUE_FULL when the queue is already full of data
+ * =====================================================================================
+ */
+int OS_QueueReserve (uint32_t queue_id, void **data)
+{
+    msg_t *new;
+    vmsg_t *rec;
+    int32_t level;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
 
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    /* Check Parameters */
-    WLOCK();
+    if (data == NULL)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _QUEUE_IS_SPSC(queue_id) )
     {
-        for(possible_qid = 0; possible_qid < OS_MAX_QUEUES; possible_qid++)
+        /*  The slot stays free in the ring until it is committed   */
+        if( spsc_ring_free(&os_queue_table[queue_id].ring, 1) == 0 )
         {
-            if (os_queue_table[possible_qid].free == TRUE)
-                break;
+            _os_queue_stats_drop(queue_id, 1);
+            os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
         }
 
-        if( possible_qid >= OS_MAX_QUEUES || os_queue_table[possible_qid].free != TRUE)
-        {
-            WUNLOCK();
+        new = spsc_ring_tail_slot(&os_queue_table[queue_id].ring, 0);
+        new->msg_state = _QUEUE_MSG_RESERVED;
+        *data = _QUEUE_MSG_DATA(new);
+        return 0;
+    }
 
-            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        /*  The slot is claimed so consumers wait for it to be committed */
+        new = mpmc_ring_claim_put(_QUEUE_MPMC(queue_id));
+        if( new == NULL )
+        {
+            _os_queue_stats_drop(queue_id, 1);
+            os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
         }
 
-        /* set the ID free to false to prevent other tasks from grabbing it */
-        os_queue_table[possible_qid].free = FALSE;   
+        new->msg_seq = mpmc_ring_seq(new);
+        new->msg_state = _QUEUE_MSG_RESERVED;
+        *data = _QUEUE_MSG_DATA(new);
+        return 0;
     }
-    WUNLOCK();
-
-    /*  Aligne the size fo 32 bits so it does not cause any memory trap  */
-    if( data_size & 0x3 )
-        size_aligned = (data_size+4) & ~0x00000003;
-    else
-        size_aligned = data_size;
 
-    /*
-     ** Create the message queue.
-     */
-    pool_init_memory( &os_queue_table[possible_qid].msg_pool.pool, (uint8_t*)buffer, buffer_size, size_aligned);
-
-    /*
-     ** If the operation failed, report the error */
-
-    /* Set the name of the queue, and the mul_Creator as well */
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        /*  Room for the largest message, trimmed when it is committed  */
+        rec = _os_queue_var_alloc(queue_id, os_queue_table[queue_id].data_size);
+        if( rec == NULL )
+        {
+            _os_queue_stats_drop(queue_id, 1);
+            os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
+        }
 
-    *queue_id = possible_qid;
+        *data = _QUEUE_VAR_DATA(rec);
+        return 0;
+    }
 
-    WLOCK();
+    _QUEUE_LOCK(queue_id, level);
+    new = pool_alloc_elem( &os_queue_table[queue_id].msg_pool.pool);
+    if( new != NULL )
+        os_queue_table[queue_id].msg_pool.allocated++;    // increase the allocated buffers
+    _QUEUE_UNLOCK(queue_id, level);
+    if( (new == NULL) && _QUEUE_IS_OVERWRITE(queue_id) )
+        new = _os_queue_recycle_msg(queue_id);
+    if( new == NULL )
     {
-        os_queue_table[*queue_id].free = FALSE;
-        os_queue_table[*queue_id].mul_Creator = OS_TaskGetId();
-        os_queue_table[*queue_id].is_blocking = (flags == OS_NONBLOCKING) ? flags : OS_BLOCKING;
-        os_queue_table[*queue_id].msg_pool.allocated = 0;    // clear the allocated buffers
-
-        /*  Stats   */
-        STATS_CREAT_QUEUE();
+        _os_queue_stats_drop(queue_id, 1);
+        os_return_minus_one_and_set_errno(OS_STATUS_QUEUE_FULL);
     }
-    WUNLOCK();
+
+    new->msg_state = _QUEUE_MSG_RESERVED;
+    *data = _QUEUE_MSG_DATA(new);
 
     return 0;
 
-} /* end OS_QueueCreate */
+}/* end OS_QueueReserve */
 
 /* 
  * ===  FUNCTION  ======================================================================
- *         Name:  OS_QueueDelete
- *  Description:  This function deletes the queue object referenced by
- *  'queue_id'.
+ *         Name:  OS_QueueCommit
+ *  Description:  This function queues the slot previously obtained with
+ *  OS_QueueReserve() without copying its content.
  *  Parameters:
  *      - queue_id: queue identifier
+ *      - data:     reserved slot payload
+ *      - size:     data size
+ *      - prio:     message priority.
  *  Returns:
  *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'data' pointer is not a slot of the queue
+ *      OS_STATUS_EINVAL when the slot is not reserved, or already committed
  *      OS_STATUS_EINVAL when the 'queue_id' is not valid
- *      OS_STATUS_EERR when any other error occurs
- *
- * NOTE: This function is only allow in the non-LOCAL resource allocation mode,
- * which can be seleceted during OSAL configuraiton.
+ *      OS_STATUS_EERR when any other error occurrs.
  * =====================================================================================
  */
-int OS_QueueDelete (uint32_t queue_id)
+int OS_QueueCommit (uint32_t queue_id, void *data, uint32_t size, uint32_t prio)
 {
+    uint32_t stamp;
+    msg_t *new;
+    vmsg_t *rec;
+    int32_t level;
+
     _CHECK_QUEUE_INIT();
 
-#if defined (CONFIG_OS_STATIC_RESOURCE_ALLOCATION)
-    os_return_minus_one_and_set_errno(OS_STATUS_EERR);
-#else
-    /* Check to see if the queue_id given is valid */
+    stamp = _os_queue_stamp();
 
-    if (queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    /* Try to delete the queue */
-    if( os_queue_table[queue_id].msg_pool.allocated )
-        os_return_minus_one_and_set_errno(OS_STATUS_EBUSY);
+    if (data == NULL)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if(size == 0)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    /* 
-     * Now that the queue is deleted, remove its "presence"
-     * in os_queue_table
-     */
-    WLOCK();
+    if(size > os_queue_table[queue_id].data_size)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _QUEUE_IS_VAR(queue_id) )
     {
-        pool_init(&os_queue_table[queue_id].msg_pool.pool);
-        os_queue_table[queue_id].free = TRUE;
-        os_queue_table[queue_id].mul_Creator = UNINITIALIZED;
+        rec = _os_queue_var_data_to_rec(queue_id, data);
+        if( (rec == NULL) || (rec->rec_state != _QUEUE_REC_RESERVED) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-        /*  Stats   */
-        STATS_DEL_QUEUE();
+        _QUEUE_LOCK(queue_id, level);
+        rec->rec_size = byte_ring_shrink(&os_queue_table[queue_id].bytes, rec, 
+                rec->rec_size, _QUEUE_VAR_HDR_SIZE + size);
+        _QUEUE_UNLOCK(queue_id, level);
+
+        rec->msg_stamp = stamp;
+        rec->msg_size = size;
+        atomic_store_release(&rec->rec_state, _QUEUE_REC_READY);
+        if( _os_queue_signal(queue_id, 1) < 0 ) 
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        return 0;
+    }
+
+    new = _os_queue_data_to_msg(queue_id, data);
+    if( new == NULL ) os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( _QUEUE_IS_SPSC(queue_id) && 
+            (new != spsc_ring_tail_slot(&os_queue_table[queue_id].ring, 0)) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( _QUEUE_IS_MPMC(queue_id) && !mpmc_ring_is_claimed(new, new->msg_seq) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    /*  Only a reserved slot is committed, and only once    */
+    if( !atomic_cas32(&new->msg_state, _QUEUE_MSG_RESERVED, _QUEUE_MSG_QUEUED) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    new->msg_prio = prio;
+    new->msg_stamp = stamp;
+    new->msg_deadline = _QUEUE_DEADLINE(prio);
+    new->msg_size = size;
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+    {
+        spsc_ring_produce(&os_queue_table[queue_id].ring, 1);
+        _os_queue_signal(queue_id, 1);
+        return 0;
     }
-    WUNLOCK();
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+    {
+        mpmc_ring_publish_put(_QUEUE_MPMC(queue_id), new);
+        if( _os_queue_signal(queue_id, 1) < 0 ) 
+            os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        return 0;
+    }
+
+    _QUEUE_LOCK(queue_id, level);
+    _os_queue_enqueue(queue_id, new);
+    _QUEUE_UNLOCK(queue_id, level);
+    if( _os_queue_signal(queue_id, 1) < 0 ) 
+        os_return_minus_one_and_set_errno(OS_STATUS_EERR);
 
     return 0;
-#endif
 
-} /* end OS_QueueDelete */
+}/* end OS_QueueCommit */
 
 /* 
  * ===  FUNCTION  ======================================================================
- *         Name:  OS_QueueGet
- *  Description:  This function retrieves data items from the referenced queue.
+ *         Name:  OS_QueueBorrow
+ *  Description:  This function retrieves the next message from the
+ *  referenced queue without copying it. The slot stays owned by the caller
+ *  until it is handed back with OS_QueueRelease().
  *  Parameters:
  *      - queue_id:     queue identifier
- *      - data:         data retrieved
- *      - size:         maximum size of the data element being gathered
- *      - size_copied:  actual size of the data retrieved
+ *      - data:         pointer to the message payload
+ *      - size:         actual size of the message
  *      - timeout:      time out
  *  Returns:
  *      0 when the call success
  *      OS_STATUS_EINVAL when the queue identifier is not valid
  *      OS_STATUS_EINVAL when any of the pointer parameters are not valid
- *      OS_STATUS_QUEUE_EMPTY when the queue is empty
  *      OS_STATUS_TIMEOUT when the timeout expires
+ *      OS_STATUS_EERR when no message could be retrieved
+ *      OS_STATUS_EBUSY when the head of an OS_QUEUE_SPSC queue is borrowed
  * =====================================================================================
  */
-int OS_QueueGet (
-        uint32_t queue_id, 
-        void *data, 
-        uint32_t size, 
-        size_t *size_copied, 
-        int32_t timeout)
+int OS_QueueBorrow (uint32_t queue_id, void **data, size_t *size, int32_t timeout)
 {
-    int ret;
-    msg_t *msg = NULL;
-
-    /* msecs rounded to the closest system tick count */
+    msg_t *msg;
+    vmsg_t *rec;
 
     _CHECK_QUEUE_INIT();
 
     /* Check Parameters */
 
     if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
-    {
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( (data == NULL) || (size == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _QUEUE_IS_VAR(queue_id) )
+    {
+        rec = _os_queue_var_wait(queue_id, timeout);
+        if( rec == NULL ) return -1;
+
+        *data = _QUEUE_VAR_DATA(rec);
+        *size = rec->msg_size;
+        return 0;
     }
+
+    if( _QUEUE_IS_SPSC(queue_id) )
+        msg = _os_queue_spsc_wait(queue_id, timeout);
+    else if( _QUEUE_IS_MPMC(queue_id) )
+        msg = _os_queue_mpmc_wait(queue_id, timeout);
     else
+        msg = _os_queue_wait_msg(queue_id, timeout);
+    if( msg == NULL ) return -1;
+
+    if( _QUEUE_IS_MPMC(queue_id) )
+        msg->msg_seq = mpmc_ring_seq(msg);
+    msg->msg_state = _QUEUE_MSG_BORROWED;
+    *data = _QUEUE_MSG_DATA(msg);
+    *size = msg->msg_size;
+
+    return 0;
+
+}/* end OS_QueueBorrow */
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_QueueRelease
+ *  Description:  This function returns to the queue the slot obtained with
+ *  OS_QueueBorrow(), or a slot reserved with OS_QueueReserve() that will not
+ *  be committed.
+ *  Parameters:
+ *      - queue_id: queue identifier
+ *      - data:     slot payload
+ *  Returns:
+ *      0 when the call success
+ *      OS_STATUS_EINVAL when the 'data' pointer is not a slot of the queue
+ *      OS_STATUS_EINVAL when the slot is neither reserved nor borrowed, as
+ *      when it is released twice or it is still queued
+ *      OS_STATUS_EINVAL when the 'queue_id' is not valid
+ * =====================================================================================
+ */
+int OS_QueueRelease (uint32_t queue_id, void *data)
+{
+    msg_t *msg;
+    vmsg_t *rec;
+
+    _CHECK_QUEUE_INIT();
+
+    /* Check Parameters */
+
+    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if (data == NULL)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _QUEUE_IS_VAR(queue_id) )
     {
-        if( (data == NULL) || (size_copied == NULL) )
+        /*  A reserved record is skipped by the consumers once released */
+        rec = _os_queue_var_data_to_rec(queue_id, data);
+        if( (rec == NULL) || ((rec->rec_state != _QUEUE_REC_RESERVED) && 
+                    (rec->rec_state != _QUEUE_REC_READING)) )
             os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+        _os_queue_var_free(queue_id, rec);
+        return 0;
     }
 
-    if( timeout > 0 )
+    msg = _os_queue_data_to_msg(queue_id, data);
+    if( msg == NULL ) os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    if( _QUEUE_IS_SPSC(queue_id) )
     {
-        /*
-         * Wait for up to a specified amount of time for a message to arrive.
-         * If no message arrives within the timeout interval, return with a
-         * failure indication.
-         */
-        ret = OS_CountSemTimedWait(os_queue_table[queue_id].semid, timeout);
-        if( ret < 0 ) os_return_minus_one_and_set_errno(OS_STATUS_TIMEOUT);
+        /*  A reserved slot was never taken from the ring   */
+        if( (msg == spsc_ring_tail_slot(&os_queue_table[queue_id].ring, 0)) &&
+                atomic_cas32(&msg->msg_state, _QUEUE_MSG_RESERVED, _QUEUE_MSG_FREE) )
+            return 0;
+
+        if( (os_queue_table[queue_id].ring.head == os_queue_table[queue_id].ring.tail) || 
+                (msg != spsc_ring_head_slot(&os_queue_table[queue_id].ring, 0)) ||
+                !atomic_cas32(&msg->msg_state, _QUEUE_MSG_BORROWED, _QUEUE_MSG_FREE) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-        msg = _os_queue_get_msg( &os_queue_table[queue_id].msg_list );
+        spsc_ring_consume(&os_queue_table[queue_id].ring, 1);
+        _os_queue_space_signal(queue_id, 1);
+        return 0;
     }
-    else
+
+    if( _QUEUE_IS_MPMC(queue_id) )
     {
-        if( os_queue_table[queue_id].is_blocking == OS_BLOCKING )
-        {
-            /*
-             * Pend forever until a message arrives.
-             */
-            ret = OS_CountSemTake(os_queue_table[queue_id].semid);
-            if( ret < 0 ) os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        /*  A claimed slot can not be given back before the slots claimed
+         *  after it, so it is published empty and the consumers skip it */
+        if( !mpmc_ring_is_claimed(msg, msg->msg_seq) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-            /*  Get a message without waiting.  If no message is present,
-             *  return with a failure indication. 
-             */
-            msg = _os_queue_get_msg( &os_queue_table[queue_id].msg_list );
-        }
-        else if( os_queue_table[queue_id].is_blocking == OS_NONBLOCKING )
+        if( atomic_cas32(&msg->msg_state, _QUEUE_MSG_RESERVED, _QUEUE_MSG_FREE) )
         {
-            /*  Get a message without waiting.  If no message is present,
-             *  return with a failure indication.
-             */
-            msg = _os_queue_get_msg( &os_queue_table[queue_id].msg_list );
+            msg->msg_size = 0;
+            mpmc_ring_publish_put(_QUEUE_MPMC(queue_id), msg);
+            _os_queue_mpmc_drain(queue_id);
+            return 0;
         }
-        else os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-    }
 
-    if( msg )
-    {
-        *size_copied = msg->msg_size;
-        memcpy(data, msg->msg_data, msg->msg_size);
-        pool_free_elem( &os_queue_table[queue_id].msg_pool.pool, msg->msg_data );
-        os_queue_table[queue_id].msg_pool.allocated--;    // decrease the allocated buffers
+        if( !atomic_cas32(&msg->msg_state, _QUEUE_MSG_BORROWED, _QUEUE_MSG_FREE) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
+        mpmc_ring_publish_get(_QUEUE_MPMC(queue_id), msg);
+        _os_queue_space_signal(queue_id, 1);
         return 0;
     }
 
-    /*
-     * Check the status of the read operation.  If a valid message was
-     * obtained, indicate success.  If an error occurred, send an event
-     * to indicate an unexpected queue read error.
-     */
+    /*  The slot goes back to the pool once, from the task holding it   */
+    if( !atomic_cas32(&msg->msg_state, _QUEUE_MSG_BORROWED, _QUEUE_MSG_FREE) &&
+            !atomic_cas32(&msg->msg_state, _QUEUE_MSG_RESERVED, _QUEUE_MSG_FREE) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    _os_queue_free_msg(queue_id, msg);
 
-}/* end OS_QueueGet */
+    return 0;
+
+}/* end OS_QueueRelease */
 
 /* 
  * ===  FUNCTION  ======================================================================
- *         Name:  OS_QueuePut
- *  Description:  This function stores a data in the queue referenced by
- *  'queue_id'.
+ *         Name:  OS_QueueSelect
+ *  Description:  This function waits until any of the referenced queues holds
+ *  a message or the timeout expires, and reports the queues holding messages.
+ *  No message is retrieved.
  *  Parameters:
- *      - queue_id: queue identifier
- *      - data:     pointer to the data to be put
- *      - size:     data size
- *      - prio:     message priority.
+ *      - queue_ids:    array of queue identifiers
+ *      - count:        number of queues in 'queue_ids'
+ *      - ready:        array of at least 'count' entries where the
+ *      identifiers of the queues holding messages are stored
+ *      - nready:       number of entries stored in 'ready'
+ *      - timeout:      time out in milliseconds. When it is not positive
+ *      the call waits as long as needed, or not at all when every queue is
+ *      OS_NONBLOCKING, as OS_QueueGet() does
  *  Returns:
- *      0 when the call success
- *      OS_STATUS_EINVAL when the 'data' pointer is not valid
- *      OS_STATUS_EINVAL when the 'queue_id' is not valid
- *      OS_STATUS_QUEUE_FULL when the queue is already full of data
- *      OS_STATUS_EERR when any other error occurrs.
+ *      0 when at least one queue holds messages
+ *      OS_STATUS_EINVAL when any of the parameters is not valid
+ *      OS_STATUS_NO_FREE_IDS when too many tasks are already waiting
+ *      OS_STATUS_TIMEOUT when the timeout expires
+ *      OS_STATUS_EERR when the OS_NONBLOCKING queues hold no message
+ *      OS_STATUS_EERR when any other error occurs
  * =====================================================================================
  */
-int OS_QueuePut (uint32_t queue_id, void *data, uint32_t size, uint32_t prio)
+int OS_QueueSelect (
+        uint32_t queue_ids[], 
+        uint32_t count, 
+        uint32_t ready[], 
+        uint32_t *nready, 
+        int32_t timeout)
 {
-    msg_t *new;
+    uint32_t i, waiter, start, elapsed;
+    int ret = 0;
+    int poll;
 
     _CHECK_QUEUE_INIT();
 
+    start = _os_queue_msecs();
+
     /* Check Parameters */
 
-    if(queue_id >= OS_MAX_QUEUES || os_queue_table[queue_id].free == TRUE)
+    if( (queue_ids == NULL) || (ready == NULL) || (nready == NULL) || (count == 0) )
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    if (data == NULL)
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-    if(size == 0)
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    /*  Only the producers of this process could wake the shared queue
+     *  waiters up. With no timeout the call only polls when the gets on all
+     *  the queues would not wait either  */
+    poll = (timeout <= 0);
+    for( i = 0; i < count; i++ )
+    {
+        if(queue_ids[i] >= OS_MAX_QUEUES || os_queue_table[queue_ids[i]].free == TRUE)
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( _QUEUE_IS_SHARED(queue_ids[i]) )
+            os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        if( os_queue_table[queue_ids[i]].is_blocking != OS_NONBLOCKING )
+            poll = FALSE;
+    }
 
-    /* Get Message From Message Queue */
-    new = _os_queue_get_free_msg();
-    if( new == NULL ) os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    /*  Take a waiter entry */
+    WLOCK();
+    {
+        for(waiter = 0; waiter < OS_MAX_QUEUE_SELECTS; waiter++)
+        {
+            if (os_queue_select_table[waiter].free == TRUE)
+                break;
+        }
+
+        if( waiter >= OS_MAX_QUEUE_SELECTS )
+        {
+            WUNLOCK();
+            os_return_minus_one_and_set_errno(OS_STATUS_NO_FREE_IDS);
+        }
 
-    new->msg_data = pool_zalloc_elem( &os_queue_table[queue_id].msg_pool.pool);
-    if( new->msg_data == NULL ) goto err_return_msg;
-    os_queue_table[queue_id].msg_pool.allocated++;    // decrease the allocated buffers
+        if( os_queue_select_table[waiter].created == FALSE )
+        {
+            if( OS_BinSemCreate(&os_queue_select_table[waiter].semid, 0, 0) < 0 )
+            {
+                WUNLOCK();
+                os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+            }
+            os_queue_select_table[waiter].created = TRUE;
+        }
+        os_queue_select_table[waiter].free = FALSE;
+    }
+    WUNLOCK();
 
-    /** Write the buffer pointer to the queue.  If an error occurred, report it
-     ** with the corresponding SB status code.
+    /*  Drop any wake up left by the previous waiter, then register on the
+     *  queues before checking them so no message can be missed
      */
-    new->msg_prio = prio;
-    new->msg_size = size;
-    memcpy(new->msg_data, data, size);
+    OS_BinSemTryTake(os_queue_select_table[waiter].semid);
+    _os_queue_select_register(queue_ids, count, 1UL << waiter, TRUE);
+    atomic_mb();
 
-    _os_queue_put_msg(new, &os_queue_table[queue_id].msg_list);
-    int ret = OS_CountSemGive(os_queue_table[queue_id].semid);
-    if( ret < 0 ) os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    for(;;)
+    {
+        *nready = 0;
+        for( i = 0; i < count; i++ )
+        {
+            if( _os_queue_has_msg(queue_ids[i]) )
+                ready[(*nready)++] = queue_ids[i];
+        }
 
-    return 0;
+        if( (*nready > 0) || poll || (ret < 0) )
+            break;
 
-err_return_msg:
-    _os_queue_return_free_msg(new);
-    os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+        /*  The message that woke the task up may have been taken by
+         *  another consumer, only wait for the time left then  */
+        if( timeout > 0 )
+        {
+            elapsed = _os_queue_msecs() - start;
+            if( elapsed >= (uint32_t)timeout )
+                break;
+            ret = OS_BinSemTimedWait(os_queue_select_table[waiter].semid, timeout - elapsed);
+        }
+        else
+            ret = OS_BinSemTake(os_queue_select_table[waiter].semid);
+    }
 
-}/* end OS_QueuePut */
+    _os_queue_select_register(queue_ids, count, 1UL << waiter, FALSE);
+    CRITICAL( os_queue_select_table[waiter].free = TRUE );
+
+    if( *nready == 0 )
+    {
+        os_return_minus_one_and_set_errno((timeout > 0) ? OS_STATUS_TIMEOUT : OS_STATUS_EERR);
+    }
+
+    return 0;
+
+}/* end OS_QueueSelect */
 
 /* 
  * ===  FUNCTION  ======================================================================
@@ -538,6 +3298,9 @@ err_return_msg:
  */
 int OS_QueueGetInfo (uint32_t queue_id, OS_queue_prop_t *queue_prop)  
 {
+    uint32_t gets, i;
+    int32_t depth;
+
     _CHECK_QUEUE_INIT();
 
     /* Check to see that the id given is valid */
@@ -552,9 +3315,33 @@ int OS_QueueGetInfo (uint32_t queue_id, OS_queue_prop_t *queue_prop)
     WLOCK();
     {
         queue_prop -> mul_Creator =   os_queue_table[queue_id].mul_Creator;
+        queue_prop -> mul_DataSize =  os_queue_table[queue_id].data_size;
     }
     WUNLOCK();
 
+    /*
+     * The counters are sampled without stopping the producers and the
+     * consumers so the figures may be off by the messages in flight
+     */
+    gets = os_queue_table[queue_id].get_stats.gets;
+    queue_prop -> mul_Puts = os_queue_table[queue_id].put_stats.puts;
+    queue_prop -> mul_Gets = gets;
+    queue_prop -> mul_Overwrites = os_queue_table[queue_id].put_stats.overwrites;
+    queue_prop -> mul_Expired = os_queue_table[queue_id].get_stats.expired;
+    depth = (int32_t)(queue_prop -> mul_Puts - gets - queue_prop -> mul_Overwrites - 
+            queue_prop -> mul_Expired);
+    queue_prop -> mul_Depth = (depth > 0) ? depth : 0;
+    if( _QUEUE_IS_SHARED(queue_id) )
+    {
+        /*  The counters only see the calls of this process */
+        queue_prop -> mul_Depth = _QUEUE_MPMC(queue_id)->enqueue_pos - 
+            _QUEUE_MPMC(queue_id)->dequeue_pos;
+    }
+    queue_prop -> mul_PeakDepth = os_queue_table[queue_id].put_stats.peak;
+    queue_prop -> mul_Drops = os_queue_table[queue_id].put_stats.drops;
+    for( i = 0; i < OS_QUEUE_LATENCY_BUCKETS; i++ )
+        queue_prop -> mul_Latency[i] = os_queue_table[queue_id].get_stats.latency[i];
+
 
     return 0;
 
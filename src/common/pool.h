@@ -16,13 +16,39 @@ struct s_pool {
 
 };
 
-#define MINIMUM_ELEMENT_SIZE 4
+/* Free elements store the link to the next free element in their first bytes,
+ * so an element can never be smaller than a pointer */
+#define MINIMUM_ELEMENT_SIZE sizeof(void *)
+
+/* Link to the next free element, stored inside the free element itself */
+#define POOL_NEXT_FREE(ptr)  (*((void **)(ptr)))
+
+/* Word the clears are done with, it aliases the element contents */
+typedef unsigned long __attribute__((__may_alias__)) pool_word_t;
+
+/*
+ * Clears 'size' bytes from 'ptr' a word at a time. The elements are not word
+ * aligned when the data size is not a multiple of the word, the bytes up to
+ * the first word boundary and after the last one are cleared one by one.
+ */
+static inline void pool_clear(void * ptr, uint32_t size)
+{
+    uint8_t * p = (uint8_t *)ptr;
+    pool_word_t * w;
+
+    for (; (size > 0) && ((unsigned long)p & (sizeof(pool_word_t) - 1)); size--)
+        *p++ = 0;
+
+    for (w = (pool_word_t *)p; size >= sizeof(pool_word_t); size -= sizeof(pool_word_t))
+        *w++ = 0;
+
+    for (p = (uint8_t *)w; size > 0; size--)
+        *p++ = 0;
+}
 
 static inline void pool_init(struct s_pool * pool)
 {
-    int i;
-    for (i = 0; i < sizeof(struct s_pool); i++)
-        *(((uint8_t *)pool) + i) = 0;
+    pool_clear(pool, sizeof(struct s_pool));
 }
 
 /*
@@ -47,14 +73,20 @@ static inline void pool_init_memory(struct s_pool * pool,
                                                           MINIMUM_ELEMENT_SIZE;
 
     pool->free_blocks_list = ptr = (void *)address;
-    pool->free_blocks = memsize/datasize;
+    pool->free_blocks = memsize/pool->data_size;
+
+    if (pool->free_blocks == 0)
+    {
+        pool->free_blocks_list = NULL;
+        return;
+    }
 
     for (i = 0; i < pool->free_blocks - 1; i++)
     {
-        *((int *)ptr) = ((int)(ptr + datasize));
-        ptr = ptr + datasize;
+        POOL_NEXT_FREE(ptr) = (uint8_t *)ptr + pool->data_size;
+        ptr = (uint8_t *)ptr + pool->data_size;
     }
-    *((int *)ptr) = 0;
+    POOL_NEXT_FREE(ptr) = NULL;
 
 }
 
@@ -65,7 +97,7 @@ static inline void * pool_alloc_elem(struct s_pool * pool)
     ptr = pool->free_blocks_list;
     if (pool->free_blocks > 0)
     {
-        pool->free_blocks_list = (void *)(*((int *)pool->free_blocks_list));
+        pool->free_blocks_list = POOL_NEXT_FREE(pool->free_blocks_list);
         pool->free_blocks--;
     }
     return ptr;
@@ -75,17 +107,13 @@ static inline void * pool_alloc_elem(struct s_pool * pool)
 static inline void * pool_zalloc_elem(struct s_pool * pool)
 {
     void * ptr;
-    int i;
     ptr = pool->free_blocks_list;
 
     if (pool->free_blocks > 0)
     {
-        pool->free_blocks_list = (void *)(*((int *)pool->free_blocks_list));
+        pool->free_blocks_list = POOL_NEXT_FREE(pool->free_blocks_list);
         pool->free_blocks--;
-        for (i = 0; i < pool->data_size; i++)
-        {
-            *(((uint8_t *)ptr) + i) = 0;
-        }
+        pool_clear(ptr, pool->data_size);
     }
     return ptr;
 }
@@ -100,7 +128,7 @@ static inline uint32_t pool_alloc_nelem(struct s_pool * pool, void * ptrarray[],
          elements--, allocated++, pool->free_blocks--)
     {
         ptrarray[allocated] = pool->free_blocks_list;
-        pool->free_blocks_list = (void *)(*((int *)pool->free_blocks_list));
+        pool->free_blocks_list = POOL_NEXT_FREE(pool->free_blocks_list);
     }
     return allocated;
 
@@ -108,7 +136,6 @@ static inline uint32_t pool_alloc_nelem(struct s_pool * pool, void * ptrarray[],
 
 static inline uint32_t pool_zalloc_nelem(struct s_pool * pool, void * ptrarray[], uint32_t num_elements)
 {
-    int i;
     int allocated;
     int elements;
 
@@ -117,82 +144,70 @@ static inline uint32_t pool_zalloc_nelem(struct s_pool * pool, void * ptrarray[]
          elements--, allocated++, pool->free_blocks--)
     {
         ptrarray[allocated] = pool->free_blocks_list;
-        pool->free_blocks_list = (void *)(*((int *)pool->free_blocks_list));
-        for (i = 0; i < pool->data_size; i++)
-        {
-            *(((uint8_t *)ptrarray[allocated]) + i) = 0;
-        }
+        pool->free_blocks_list = POOL_NEXT_FREE(pool->free_blocks_list);
+        pool_clear(ptrarray[allocated], pool->data_size);
     }
     return allocated;
 }
 
 
+/*
+ * The free functions do not check the elements belong to the pool, the
+ * callers make sure they do (see pool_owns_elem).
+ */
+
+static inline int pool_owns_elem(struct s_pool * pool, void * elem)
+{
+    return ((uint8_t *)elem >= pool->memory_area) &&
+       ((uint8_t *)elem < (pool->memory_area + pool->memory_area_size));
+}
+
 static inline void pool_free_elem(struct s_pool * pool, void * elem)
 {
     void * ptr = elem;
-    // Sanity check
-    if (unlikely(((int)elem >= (int)pool->memory_area) &&
-       ((int)elem <= (int)(pool->memory_area + pool->memory_area_size))))
-    {
-        *((int *)ptr) = (int)pool->free_blocks_list;
 
-        pool->free_blocks_list = ptr;
-        pool->free_blocks++;
-    }
+    POOL_NEXT_FREE(ptr) = pool->free_blocks_list;
+
+    pool->free_blocks_list = ptr;
+    pool->free_blocks++;
 }
 
 static inline void pool_zfree_elem(struct s_pool * pool, void * elem)
 {
     void * ptr = elem;
-    int i;
-    // Sanity check
-    if (unlikely(((int)elem >= (int)pool->memory_area) &&
-       ((int)elem <= (int)(pool->memory_area + pool->memory_area_size))))
-    {
 
-        for (i = 0; i < pool->data_size; i++)
-            *(((uint8_t *)ptr) + i) = 0;
-        *((int *)ptr) = (int)pool->free_blocks_list;
+    pool_clear(ptr, pool->data_size);
+    POOL_NEXT_FREE(ptr) = pool->free_blocks_list;
 
-        pool->free_blocks_list = ptr;
-        pool->free_blocks++;
-    }
+    pool->free_blocks_list = ptr;
+    pool->free_blocks++;
 }
 
 static inline void pool_free_nelem(struct s_pool * pool, void * ptrarray[], uint32_t num_elements)
 {
     int i;
-    // Sanity check
+
     for (i = 0; i < num_elements; i++) 
     {
-        if (unlikely(((int)ptrarray[i] >= (int)pool->memory_area) &&
-           ((int)ptrarray[i] <= (int)(pool->memory_area + pool->memory_area_size))))
-        {
-            *((int *)ptrarray[i]) = (int)pool->free_blocks_list;
-
-            pool->free_blocks_list = ptrarray[i];
-            pool->free_blocks++;
-        }
+        POOL_NEXT_FREE(ptrarray[i]) = pool->free_blocks_list;
+
+        pool->free_blocks_list = ptrarray[i];
+        pool->free_blocks++;
     }
 }
 
 static inline void pool_zfree_nelem(struct s_pool * pool, void * ptrarray[], uint32_t num_elements)
 {
-    int i, j;
-    // Sanity check
+    int i;
+
     for (i = 0; i < num_elements; i++) 
     {
-        if (unlikely(((int)ptrarray[i] >= (int)pool->memory_area) &&
-           ((int)ptrarray[i] <= (int)(pool->memory_area + pool->memory_area_size))))
-        {
-            for (j = 0; j < pool->data_size; j++)
-                *(((uint8_t *)ptrarray[i]) + j) = 0;
+        pool_clear(ptrarray[i], pool->data_size);
 
-            *((int *)ptrarray[i]) = (int)pool->free_blocks_list;
+        POOL_NEXT_FREE(ptrarray[i]) = pool->free_blocks_list;
 
-            pool->free_blocks_list = ptrarray[i];
-            pool->free_blocks++;
-        }
+        pool->free_blocks_list = ptrarray[i];
+        pool->free_blocks++;
     }
 }
 
@@ -201,4 +216,128 @@ static inline uint32_t pool_num_free_elements(struct s_pool * pool)
     return pool->free_blocks;
 }
 
+/*
+ * Lock-free variant of the pool. The free list links the elements by their
+ * 32-bit index plus one, zero ending the list, so it does not depend on the
+ * pointer size. The head index shares a 64-bit word with a generation
+ * number, incremented by every update, so a compare-and-swap fails when the
+ * head was taken and given back meanwhile (ABA).
+ */
+struct s_lf_pool {
+
+    uint8_t * memory_area;
+
+    uint32_t memory_area_size;
+
+    uint32_t data_size;
+
+    uint32_t num_elements;
+
+    volatile uint32_t free_blocks;
+
+    /* Generation in the upper half, head index plus one in the lower one */
+    volatile uint64_t head;
+
+};
+
+#define LF_POOL_HEAD(gen, idx)  (((uint64_t)(gen) << 32) | (uint32_t)(idx))
+#define LF_POOL_GEN(head)       ((uint32_t)((head) >> 32))
+#define LF_POOL_IDX(head)       ((uint32_t)(head))
+
+/* Link to the next free element, stored inside the free element itself */
+#define LF_POOL_NEXT_FREE(ptr)  (*((volatile uint32_t *)(ptr)))
+
+/*
+ * Initializes the lock-free pool. The size of the elements is rounded up to
+ * a multiple of 4 bytes so the links are aligned.
+ */
+static inline void lf_pool_init_memory(struct s_lf_pool * pool,
+                                       uint8_t * address,
+                                       uint32_t memsize,
+                                       uint32_t datasize)
+{
+    uint32_t i;
+
+    pool->memory_area = address;
+    pool->memory_area_size = memsize;
+    pool->data_size = (datasize + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+    if (pool->data_size == 0)
+        pool->data_size = sizeof(uint32_t);
+
+    pool->num_elements = memsize/pool->data_size;
+    pool->free_blocks = pool->num_elements;
+    pool->head = LF_POOL_HEAD(0, pool->num_elements ? 1 : 0);
+
+    for (i = 0; i < pool->num_elements; i++)
+    {
+        LF_POOL_NEXT_FREE(address + i * pool->data_size) = 
+            (i + 1 < pool->num_elements) ? i + 2 : 0;
+    }
+}
+
+static inline void * lf_pool_alloc_elem(struct s_lf_pool * pool)
+{
+    uint64_t head, next;
+    uint8_t * ptr;
+
+    head = atomic_load64(&pool->head);
+    do
+    {
+        if (LF_POOL_IDX(head) == 0)
+            return NULL;
+
+        /* The element may be taken meanwhile and the link read be garbage,
+         * the generation makes the swap fail then */
+        ptr = pool->memory_area + (LF_POOL_IDX(head) - 1) * pool->data_size;
+        next = LF_POOL_HEAD(LF_POOL_GEN(head) + 1, LF_POOL_NEXT_FREE(ptr));
+
+        if (atomic_cas64(&pool->head, head, next))
+            break;
+        head = atomic_load64(&pool->head);
+    } while (1);
+
+    atomic_add32(&pool->free_blocks, (uint32_t)-1);
+
+    return ptr;
+}
+
+/*
+ * Returns the element to the lock-free pool. Returns -1 when 'elem' is not
+ * an element of the pool.
+ */
+static inline int lf_pool_free_elem(struct s_lf_pool * pool, void * elem)
+{
+    uint64_t head, next;
+    uint32_t offset;
+
+    if (unlikely(((uint8_t *)elem < pool->memory_area) ||
+       ((uint8_t *)elem >= (pool->memory_area + 
+                            pool->num_elements * pool->data_size))))
+        return -1;
+
+    offset = (uint8_t *)elem - pool->memory_area;
+    if (unlikely(offset % pool->data_size))
+        return -1;
+
+    head = atomic_load64(&pool->head);
+    do
+    {
+        LF_POOL_NEXT_FREE(elem) = LF_POOL_IDX(head);
+        next = LF_POOL_HEAD(LF_POOL_GEN(head) + 1, offset / pool->data_size + 1);
+
+        if (atomic_cas64(&pool->head, head, next))
+            break;
+        head = atomic_load64(&pool->head);
+    } while (1);
+
+    atomic_add32(&pool->free_blocks, 1);
+
+    return 0;
+}
+
+static inline uint32_t lf_pool_num_free_elements(struct s_lf_pool * pool)
+{
+    return pool->free_blocks;
+}
+
 #endif // __POOL__POOL_H__
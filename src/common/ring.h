@@ -0,0 +1,447 @@
+#ifndef __RING__RING_H__
+#define __RING__RING_H__
+
+#include <public/atomic.h>
+
+/*
+ * Single-producer/single-consumer ring of fixed size slots. The producer only
+ * writes 'tail' and the consumer only writes 'head', each one in its own cache
+ * line together with the copy of the other index last seen, so the indices
+ * are exchanged with acquire/release accesses only and without any lock.
+ *
+ * Indices run over [0, 2 * nslots) so a full ring can be told from an empty
+ * one without sacrificing a slot and 'nslots' does not need to be a power of
+ * two.
+ */
+struct s_spsc_ring {
+
+    uint8_t * memory_area;
+
+    uint32_t slot_size;
+
+    uint32_t nslots;
+
+    /*  Consumer side   */
+    volatile uint32_t head CACHE_ALIGNED;
+
+    uint32_t tail_cache;
+
+    /*  Producer side   */
+    volatile uint32_t tail CACHE_ALIGNED;
+
+    uint32_t head_cache;
+
+    /*  Set by the consumer before sleeping on an empty ring    */
+    volatile uint32_t waiting CACHE_ALIGNED;
+
+};
+
+static inline void spsc_ring_init(struct s_spsc_ring * ring,
+                                  uint8_t * address,
+                                  uint32_t slot_size,
+                                  uint32_t nslots)
+{
+    ring->memory_area = address;
+    ring->slot_size = slot_size;
+    ring->nslots = nslots;
+    ring->head = ring->tail_cache = 0;
+    ring->tail = ring->head_cache = 0;
+    ring->waiting = 0;
+}
+
+static inline uint32_t spsc_ring_next(struct s_spsc_ring * ring,
+                                      uint32_t index,
+                                      uint32_t n)
+{
+    index += n;
+    if (index >= 2 * ring->nslots)
+        index -= 2 * ring->nslots;
+    return index;
+}
+
+static inline uint32_t spsc_ring_count(struct s_spsc_ring * ring,
+                                       uint32_t head,
+                                       uint32_t tail)
+{
+    return (tail >= head) ? tail - head : 2 * ring->nslots + tail - head;
+}
+
+/* Slot 'n' positions after 'index' */
+static inline void * spsc_ring_slot(struct s_spsc_ring * ring,
+                                    uint32_t index,
+                                    uint32_t n)
+{
+    index = spsc_ring_next(ring, index, n);
+    if (index >= ring->nslots)
+        index -= ring->nslots;
+    return ring->memory_area + index * ring->slot_size;
+}
+
+/* Producer: number of slots that can be filled. The consumer index is only
+ * read again when the last copy seen does not leave 'want' free slots */
+static inline uint32_t spsc_ring_free(struct s_spsc_ring * ring, uint32_t want)
+{
+    uint32_t used = spsc_ring_count(ring, ring->head_cache, ring->tail);
+
+    if (ring->nslots - used < want)
+    {
+        ring->head_cache = atomic_load_acquire(&ring->head);
+        used = spsc_ring_count(ring, ring->head_cache, ring->tail);
+    }
+    return ring->nslots - used;
+}
+
+/* Producer: 'n'th free slot */
+static inline void * spsc_ring_tail_slot(struct s_spsc_ring * ring, uint32_t n)
+{
+    return spsc_ring_slot(ring, ring->tail, n);
+}
+
+/* Producer: hands the next 'n' filled slots to the consumer */
+static inline void spsc_ring_produce(struct s_spsc_ring * ring, uint32_t n)
+{
+    atomic_store_release(&ring->tail, spsc_ring_next(ring, ring->tail, n));
+}
+
+/* Consumer: number of slots ready to be read. The producer index is only
+ * read again when the last copy seen does not provide 'want' slots */
+static inline uint32_t spsc_ring_avail(struct s_spsc_ring * ring, uint32_t want)
+{
+    uint32_t avail = spsc_ring_count(ring, ring->head, ring->tail_cache);
+
+    if (avail < want)
+    {
+        ring->tail_cache = atomic_load_acquire(&ring->tail);
+        avail = spsc_ring_count(ring, ring->head, ring->tail_cache);
+    }
+    return avail;
+}
+
+/* Consumer: 'n'th slot ready to be read */
+static inline void * spsc_ring_head_slot(struct s_spsc_ring * ring, uint32_t n)
+{
+    return spsc_ring_slot(ring, ring->head, n);
+}
+
+/* Consumer: gives the next 'n' read slots back to the producer */
+static inline void spsc_ring_consume(struct s_spsc_ring * ring, uint32_t n)
+{
+    atomic_store_release(&ring->head, spsc_ring_next(ring, ring->head, n));
+}
+
+/*
+ * Bounded multi-producer/multi-consumer ring of fixed size slots (D. Vyukov).
+ * Every slot starts with a sequence number telling whether it is free for
+ * the enqueue position or ready for the dequeue position; producers and
+ * consumers claim positions with a compare-and-swap and publish the slot
+ * with a release store of its sequence number. The number of slots shall be
+ * a power of two.
+ *
+ * The slots are found from the address of the ring itself, so a ring placed
+ * in memory shared by several processes works wherever each one maps it.
+ */
+struct s_mpmc_ring {
+
+    /* Distance from the ring to its slots */
+    intptr_t area_offset;
+
+    uint32_t slot_size;
+
+    uint32_t mask;
+
+    volatile uint32_t enqueue_pos CACHE_ALIGNED;
+
+    volatile uint32_t dequeue_pos CACHE_ALIGNED;
+
+};
+
+/* Bytes of every slot taken by the sequence number, keeping the element
+ * that follows aligned to the pointer size */
+#define MPMC_RING_HDR_SIZE      sizeof(void *)
+
+#define MPMC_RING_SEQ(slot)     (*((volatile uint32_t *)(slot)))
+
+/* Slot element from its sequence number address, and the other way round */
+#define MPMC_RING_ELEM(slot)    ((void *)((uint8_t *)(slot) + MPMC_RING_HDR_SIZE))
+#define MPMC_RING_SLOT(elem)    ((uint8_t *)(elem) - MPMC_RING_HDR_SIZE)
+
+static inline void mpmc_ring_init(struct s_mpmc_ring * ring,
+                                  uint8_t * address,
+                                  uint32_t slot_size,
+                                  uint32_t nslots)
+{
+    uint32_t i;
+
+    ring->area_offset = (intptr_t)address - (intptr_t)ring;
+    ring->slot_size = slot_size;
+    ring->mask = nslots - 1;
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+
+    for (i = 0; i < nslots; i++)
+        MPMC_RING_SEQ(address + i * slot_size) = i;
+}
+
+static inline uint8_t * mpmc_ring_area(struct s_mpmc_ring * ring)
+{
+    return (uint8_t *)ring + ring->area_offset;
+}
+
+static inline uint8_t * mpmc_ring_slot(struct s_mpmc_ring * ring, uint32_t pos)
+{
+    return mpmc_ring_area(ring) + (pos & ring->mask) * ring->slot_size;
+}
+
+/* Producer: claims the next free slot element, NULL when the ring is full */
+static inline void * mpmc_ring_claim_put(struct s_mpmc_ring * ring)
+{
+    uint32_t pos = ring->enqueue_pos;
+    uint8_t * slot;
+    int32_t diff;
+
+    for (;;)
+    {
+        slot = mpmc_ring_slot(ring, pos);
+        diff = (int32_t)(atomic_load_acquire(&MPMC_RING_SEQ(slot)) - pos);
+        if (diff == 0)
+        {
+            if (atomic_cas32(&ring->enqueue_pos, pos, pos + 1))
+                return MPMC_RING_ELEM(slot);
+        }
+        else if (diff < 0)
+            return NULL;
+
+        pos = ring->enqueue_pos;
+    }
+}
+
+/* Producer: hands the claimed and filled 'elem' to the consumers */
+static inline void mpmc_ring_publish_put(struct s_mpmc_ring * ring, void * elem)
+{
+    uint8_t * slot = MPMC_RING_SLOT(elem);
+
+    atomic_store_release(&MPMC_RING_SEQ(slot), MPMC_RING_SEQ(slot) + 1);
+}
+
+/* Consumer: claims the next ready slot element, NULL when the ring is empty
+ * or the producer of the next slot has not published it yet */
+static inline void * mpmc_ring_claim_get(struct s_mpmc_ring * ring)
+{
+    uint32_t pos = ring->dequeue_pos;
+    uint8_t * slot;
+    int32_t diff;
+
+    for (;;)
+    {
+        slot = mpmc_ring_slot(ring, pos);
+        diff = (int32_t)(atomic_load_acquire(&MPMC_RING_SEQ(slot)) - (pos + 1));
+        if (diff == 0)
+        {
+            if (atomic_cas32(&ring->dequeue_pos, pos, pos + 1))
+                return MPMC_RING_ELEM(slot);
+        }
+        else if (diff < 0)
+            return NULL;
+
+        pos = ring->dequeue_pos;
+    }
+}
+
+/* Consumer: the ready slot element at the dequeue position, left unclaimed,
+ * NULL when there is none. 'pos' returns the position to claim it at */
+static inline void * mpmc_ring_peek(struct s_mpmc_ring * ring, uint32_t * pos)
+{
+    uint8_t * slot;
+
+    *pos = ring->dequeue_pos;
+    slot = mpmc_ring_slot(ring, *pos);
+    if (atomic_load_acquire(&MPMC_RING_SEQ(slot)) != *pos + 1)
+        return NULL;
+
+    return MPMC_RING_ELEM(slot);
+}
+
+/* Consumer: claims the element peeked at 'pos', fails when another consumer
+ * claimed it first */
+static inline int mpmc_ring_claim_at(struct s_mpmc_ring * ring, uint32_t pos)
+{
+    return atomic_cas32(&ring->dequeue_pos, pos, pos + 1);
+}
+
+/* Consumer: gives the claimed 'elem' back to the producers */
+static inline void mpmc_ring_publish_get(struct s_mpmc_ring * ring, void * elem)
+{
+    uint8_t * slot = MPMC_RING_SLOT(elem);
+
+    atomic_store_release(&MPMC_RING_SEQ(slot), MPMC_RING_SEQ(slot) + ring->mask);
+}
+
+/* Whether the slot at the dequeue position is ready to be claimed */
+static inline int mpmc_ring_ready(struct s_mpmc_ring * ring)
+{
+    uint32_t pos = ring->dequeue_pos;
+
+    return atomic_load_acquire(&MPMC_RING_SEQ(mpmc_ring_slot(ring, pos))) == pos + 1;
+}
+
+/* Sequence number of the slot of 'elem'. Read right after the slot is
+ * claimed it is the position claimed by a producer, or the position claimed
+ * by a consumer plus one */
+static inline uint32_t mpmc_ring_seq(void * elem)
+{
+    return MPMC_RING_SEQ(MPMC_RING_SLOT(elem));
+}
+
+/* Whether 'elem' is still claimed with the sequence number 'seq' read when
+ * it was claimed, that is neither published nor claimed again since */
+static inline int mpmc_ring_is_claimed(void * elem, uint32_t seq)
+{
+    return atomic_load_acquire(&MPMC_RING_SEQ(MPMC_RING_SLOT(elem))) == seq;
+}
+
+/*
+ * Ring of variable size records packed in a contiguous memory area. Records
+ * are allocated at 'tail', handed to the readers in the same order at 'read'
+ * and freed in the same order again at 'head'. A record never wraps: when it
+ * does not fit before the end of the area it is placed at the start and
+ * 'end' remembers where the data stops. The ring is not thread-safe, the
+ * caller shall serialize the calls.
+ */
+struct s_byte_ring {
+
+    uint8_t * memory_area;
+
+    uint32_t size;
+
+    /*  Oldest record not freed yet */
+    uint32_t head;
+
+    /*  Oldest record not read yet  */
+    uint32_t read;
+
+    /*  Where the next record is allocated  */
+    uint32_t tail;
+
+    /*  End of the data when the ring has wrapped, 'size' otherwise   */
+    uint32_t end;
+
+    /*  Records allocated, and the ones of them not read yet    */
+    uint32_t records;
+
+    uint32_t unread;
+
+};
+
+/* Records are aligned to the pointer size so their content is not misaligned */
+#define BYTE_RING_ALIGN(x) \
+    (((x) + sizeof(void *) - 1) & ~((uint32_t)sizeof(void *) - 1))
+
+static inline void byte_ring_init(struct s_byte_ring * ring,
+                                  uint8_t * address,
+                                  uint32_t size)
+{
+    ring->memory_area = address;
+    ring->size = size & ~((uint32_t)sizeof(void *) - 1);
+    ring->head = ring->read = ring->tail = 0;
+    ring->end = ring->size;
+    ring->records = ring->unread = 0;
+}
+
+/* Allocates a record of 'n' bytes, NULL when there is no room for it */
+static inline void * byte_ring_alloc(struct s_byte_ring * ring, uint32_t n)
+{
+    uint32_t off;
+
+    n = BYTE_RING_ALIGN(n);
+
+    /*  Start over from the beginning whenever the ring gets empty  */
+    if (ring->records == 0)
+    {
+        ring->head = ring->read = ring->tail = 0;
+        ring->end = ring->size;
+    }
+
+    if ((ring->tail < ring->head) ||
+            ((ring->tail == ring->head) && (ring->records > 0)))
+    {
+        /*  The free space lies between tail and head   */
+        if (ring->head - ring->tail < n)
+            return NULL;
+        off = ring->tail;
+    }
+    else if (ring->size - ring->tail >= n)
+        off = ring->tail;
+    else if (ring->head >= n)
+    {
+        /*  Wrap, a reader already at the tail moves along   */
+        if (ring->read == ring->tail)
+            ring->read = 0;
+        ring->end = ring->tail;
+        off = 0;
+    }
+    else
+        return NULL;
+
+    ring->tail = off + n;
+    if (ring->tail == ring->size)
+        ring->tail = 0;
+    ring->records++;
+    ring->unread++;
+
+    return ring->memory_area + off;
+}
+
+/* Shrinks the 'n' bytes record 'rec' to 'new_n' bytes when it is the last
+ * allocated one. Returns the size the record finally takes */
+static inline uint32_t byte_ring_shrink(struct s_byte_ring * ring,
+                                        void * rec,
+                                        uint32_t n,
+                                        uint32_t new_n)
+{
+    uint32_t off = (uint8_t *)rec - ring->memory_area;
+    uint32_t rec_end = off + BYTE_RING_ALIGN(n);
+
+    new_n = BYTE_RING_ALIGN(new_n);
+    if (rec_end == ring->size)
+        rec_end = 0;
+    if ((rec_end != ring->tail) || (new_n >= BYTE_RING_ALIGN(n)))
+        return BYTE_RING_ALIGN(n);
+
+    ring->tail = off + new_n;
+    return new_n;
+}
+
+/* Next record to be read, NULL when all of them have been read */
+static inline void * byte_ring_read_slot(struct s_byte_ring * ring)
+{
+    return (ring->unread == 0) ? NULL : ring->memory_area + ring->read;
+}
+
+/* Moves the reader past the 'n' bytes record it was at */
+static inline void byte_ring_read_next(struct s_byte_ring * ring, uint32_t n)
+{
+    ring->read += BYTE_RING_ALIGN(n);
+    if ((ring->read == ring->end) || (ring->read == ring->size))
+        ring->read = 0;
+    ring->unread--;
+}
+
+/* Oldest record already read and not freed yet, NULL when there is none */
+static inline void * byte_ring_head_slot(struct s_byte_ring * ring)
+{
+    return (ring->records == ring->unread) ? NULL : ring->memory_area + ring->head;
+}
+
+/* Frees the 'n' bytes record at the head */
+static inline void byte_ring_free(struct s_byte_ring * ring, uint32_t n)
+{
+    ring->head += BYTE_RING_ALIGN(n);
+    if ((ring->head == ring->end) || (ring->head == ring->size))
+    {
+        ring->head = 0;
+        ring->end = ring->size;
+    }
+    ring->records--;
+}
+
+#endif
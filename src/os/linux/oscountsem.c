@@ -76,6 +76,10 @@ typedef struct
 {
     int free;
     sem_t id;
+    /*  Semaphore used, 'id' or the one of a region shared with other
+     *  processes  */
+    sem_t *sem;
+    int shared;
     int mul_Creator;
 }OS_count_sem_record_t;
 
@@ -103,19 +107,20 @@ static void _os_countsem_init(void)
   COUNT SEMAPHORE API
  ****************************************************************************************/
 
-int OS_CountSemCreate (uint32_t *sem_id, 
-        uint32_t sem_initial_value,
-        uint32_t options)
+/*
+ * Takes a table entry for the semaphore 'sem', which is initialized with
+ * 'sem_initial_value' unless it is an already initialized shared one.
+ * NULL stands for the semaphore of the entry.
+ */
+static int _os_countsem_create (uint32_t *sem_id, 
+        sem_t *sem,
+        int shared,
+        int init,
+        uint32_t sem_initial_value)
 {
-    UNUSED(options);
     uint32_t possible_semid;
     int Status;
 
-    _CHECK_COUNTSEM_INIT();
-
-    if ( (sem_id == NULL) )
-        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
-
     /* Check Parameters */
 
     WLOCK();
@@ -146,7 +151,12 @@ int OS_CountSemCreate (uint32_t *sem_id,
 
     errno = 0;
 
-    Status = sem_init( &(OS_count_sem_table[possible_semid].id) ,0 , sem_initial_value);
+    if( sem == NULL )
+        sem = &(OS_count_sem_table[possible_semid].id);
+    OS_count_sem_table[possible_semid].sem = sem;
+    OS_count_sem_table[possible_semid].shared = shared;
+
+    Status = init ? sem_init( sem, shared, sem_initial_value) : 0;
     if( Status == -1 )
     {
         /* Since the call failed, set it the free flag back to true */
@@ -169,8 +179,44 @@ int OS_CountSemCreate (uint32_t *sem_id,
     WUNLOCK();
 
     return 0;
+}
+
+int OS_CountSemCreate (uint32_t *sem_id, 
+        uint32_t sem_initial_value,
+        uint32_t options)
+{
+    UNUSED(options);
+
+    _CHECK_COUNTSEM_INIT();
+
+    if ( (sem_id == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    return _os_countsem_create(sem_id, NULL, 0, 1, sem_initial_value);
 }/* end OS_CountSemCreate */
 
+int OS_CountSemCreateShared (uint32_t *sem_id, 
+        void *storage,
+        uint32_t sem_initial_value)
+{
+    _CHECK_COUNTSEM_INIT();
+
+    if ( (sem_id == NULL) || (storage == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    return _os_countsem_create(sem_id, (sem_t *)storage, 1, 1, sem_initial_value);
+}/* end OS_CountSemCreateShared */
+
+int OS_CountSemAttachShared (uint32_t *sem_id, void *storage)
+{
+    _CHECK_COUNTSEM_INIT();
+
+    if ( (sem_id == NULL) || (storage == NULL) )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    return _os_countsem_create(sem_id, (sem_t *)storage, 1, 0, 0);
+}/* end OS_CountSemAttachShared */
+
 int OS_CountSemDelete (uint32_t sem_id)
 {
     _CHECK_COUNTSEM_INIT();
@@ -184,7 +230,10 @@ int OS_CountSemDelete (uint32_t sem_id)
 
 
 
-    if (sem_destroy( &(OS_count_sem_table[sem_id].id)) != 0) /* 0 = success */ 
+    /*  A shared semaphore may still be used by other processes, it goes
+     *  away with the memory holding it */
+    if (!OS_count_sem_table[sem_id].shared &&
+            sem_destroy( OS_count_sem_table[sem_id].sem) != 0) /* 0 = success */ 
     {
         os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
     }
@@ -217,7 +266,7 @@ int OS_CountSemGive ( uint32_t sem_id )
     if(sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    ret = sem_post(&(OS_count_sem_table[sem_id].id));
+    ret = sem_post(OS_count_sem_table[sem_id].sem);
 
     if ( ret != 0 )
     {
@@ -227,6 +276,27 @@ int OS_CountSemGive ( uint32_t sem_id )
     return 0;
 }/* end OS_CountSemGive */
 
+int OS_CountSemGiveMany ( uint32_t sem_id, uint32_t count )
+{
+    _CHECK_COUNTSEM_INIT();
+
+    /* Check Parameters */
+
+    if(sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    /*  POSIX has no multiple post, but sem_post does not enter the kernel
+     *  unless there are waiters
+     */
+    for( ; count > 0; count-- )
+    {
+        if( sem_post(OS_count_sem_table[sem_id].sem) != 0 )
+            os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
+    }
+
+    return 0;
+}/* end OS_CountSemGiveMany */
+
 int OS_CountSemTake ( uint32_t sem_id )
 {
     int    ret;
@@ -236,7 +306,7 @@ int OS_CountSemTake ( uint32_t sem_id )
     if(sem_id >= OS_MAX_COUNT_SEMAPHORES  || OS_count_sem_table[sem_id].free == TRUE)
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
-    ret = sem_wait(&(OS_count_sem_table[sem_id].id));
+    ret = sem_wait(OS_count_sem_table[sem_id].sem);
 
     if ( ret != 0 )
     {
@@ -248,9 +318,8 @@ int OS_CountSemTake ( uint32_t sem_id )
 
 int OS_CountSemTimedWait ( uint32_t sem_id, uint32_t msecs )
 {
-    uint32_t           ret_val ;
+    int    ret;
     struct timespec  temp_timespec ;
-    int timeloop;
 
 
     _CHECK_COUNTSEM_INIT();
@@ -262,41 +331,26 @@ int OS_CountSemTimedWait ( uint32_t sem_id, uint32_t msecs )
     /*
      ** Compute an absolute time for the delay
      */
-    ret_val = OS_CompAbsDelayedTime( msecs , &temp_timespec) ;
+    OS_CompAbsDelayedTime( msecs , &temp_timespec) ;
 
-    /* try it this way */
-    timeloop = (msecs == 0) ? 100 : msecs;
-    for (; timeloop >0; timeloop -= 100)
+    /*  Sleep until the semaphore is given or the time expires instead of
+     *  polling it every 100 ms, so the waiter is woken up as soon as it is
+     *  given.
+     */
+    while( (ret = sem_timedwait(OS_count_sem_table[sem_id].sem, &temp_timespec)) == -1 )
     {
-        int status = -1;
-        if ( ((status = sem_trywait(&(OS_count_sem_table[sem_id].id))) == -1) && 
-                (errno == EAGAIN) )
-        {
-            /* sleep for 100 msecs */
-            usleep(100*1000);
-        }
+        if( errno != EINTR )    break;
+    }
 
-        else
-        {   /* something besides the sem being taken made it fail */
-            /* 
-             * The value of the semaphore is not left whether the call
-             * successed and the semaphore was locke, so that another
-             * sem_trywait would try to lock the sempahore twice...and
-             * the routine would fail.
-             */
-            /*             if(sem_trywait(&(OS_count_sem_table[sem_id].id)) == -1)
-            */
-            if(status == -1)
-            {
-                os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
-            }
-            else
-            {
-                return 0;
-            }
-        }
+    if( ret != 0 )
+    {
+        if( errno == ETIMEDOUT )
+            os_return_minus_one_and_set_errno(OS_STATUS_TIMEOUT);
+
+        os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
     }
-    os_return_minus_one_and_set_errno(OS_STATUS_TIMEOUT);
+
+    return 0;
 }
 
 int OS_CountSemTryTake (uint32_t sem_id)
@@ -309,7 +363,7 @@ int OS_CountSemTryTake (uint32_t sem_id)
         os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
 
     /* Note to self: Check out sem wait in the manual */
-    if ( sem_trywait(&(OS_count_sem_table[sem_id].id)) != 0)
+    if ( sem_trywait(OS_count_sem_table[sem_id].sem) != 0)
     {
         os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
     }
@@ -321,6 +375,30 @@ int OS_CountSemTryTake (uint32_t sem_id)
     os_return_minus_one_and_set_errno(OS_STATUS_EERR);
 }
 
+int OS_CountSemTryTakeMany (uint32_t sem_id, uint32_t count, uint32_t *taken)
+{
+    _CHECK_COUNTSEM_INIT();
+
+    /* Check Parameters */
+
+    if(sem_id >= OS_MAX_COUNT_SEMAPHORES  || OS_count_sem_table[sem_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( taken == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    for( *taken = 0; *taken < count; (*taken)++ )
+    {
+        if ( sem_trywait(OS_count_sem_table[sem_id].sem) != 0 )
+        {
+            if( errno != EAGAIN )
+                os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
+            break;
+        }
+    }
+
+    return 0;
+}/* end OS_CountSemTryTakeMany */
+
 int OS_CountSemGetInfo (uint32_t sem_id, OS_count_sem_prop_t *count_prop)  
 {
     _CHECK_COUNTSEM_INIT();
@@ -338,9 +338,8 @@ int OS_BinSemTryTake (uint32_t sem_id)
 
 int OS_BinSemTimedWait ( uint32_t sem_id, uint32_t msecs )
 {
-    uint32_t           ret_val ;
+    int    ret;
     struct timespec  temp_timespec ;
-    int timeloop;
 
 
     _CHECK_BINSEM_INIT();
@@ -352,40 +351,31 @@ int OS_BinSemTimedWait ( uint32_t sem_id, uint32_t msecs )
     /*
      ** Compute an absolute time for the delay
      */
-    ret_val = OS_CompAbsDelayedTime( msecs , &temp_timespec) ;
+    OS_CompAbsDelayedTime( msecs , &temp_timespec) ;
 
-    /* try it this way */
-    timeloop = (msecs == 0) ? 100 : msecs;
-    for (; timeloop >0; timeloop -= 100)
+    /*  Sleep until the semaphore is given or the time expires instead of
+     *  polling it, so the waiter is woken up as soon as it is given.
+     */
+    SEM_BLOCKED_ADD(sem_id);
+    while( (ret = sem_timedwait(&(OS_bin_sem_table[sem_id].id), &temp_timespec)) == -1 )
     {
-        int status = -1;
-        if ( (status = sem_trywait(&(OS_bin_sem_table[sem_id].id))) == -1 && errno == EAGAIN)
-        {
-            /* sleep for 100 msecs */
-            usleep(100*1000);
-        }
+        if( errno != EINTR )    break;
+    }
 
-        else
-        {   /* something besides the sem being taken made it fail */
-/*             if(sem_trywait(&(OS_bin_sem_table[sem_id].id)) == -1)
- */
-            /* 
-             * The value of the semaphore is not left whether the call
-             * successed and the semaphore was locke, so that another
-             * sem_trywait would try to lock the sempahore twice...and
-             * the routine would fail.
-             */
-            if( status == -1 )
-            {
-                os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
-            }
-            else
-            {
-                return 0;
-            }
-        }
+    /*  This is done to perform the OS_BinSemFlush() operation properly */
+    pthread_mutex_lock(&m_flush);
+    pthread_mutex_unlock(&m_flush);
+
+    SEM_BLOCKED_DEL(sem_id);
+    if( ret != 0 )
+    {
+        if( errno == ETIMEDOUT )
+            os_return_minus_one_and_set_errno(OS_STATUS_TIMEOUT);
+
+        os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
     }
-    os_return_minus_one_and_set_errno(OS_STATUS_TIMEOUT);
+
+    return 0;
 }
 
 int OS_BinSemGetInfo (uint32_t sem_id, OS_bin_sem_prop_t *bin_prop)  
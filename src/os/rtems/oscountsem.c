@@ -334,6 +334,46 @@ int OS_CountSemGive (uint32_t sem_id)
 
 }/* end OS_CountSemGive */
 
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_CountSemGiveMany
+ *  Description:  The function releases 'count' times the semaphore 'sem_id'
+ *  Parameters:
+ *      -sem_id:    semaphore identifier.
+ *      -count:     number of units to release
+ *  Return:
+ *      0 when the function success
+ *      OS_STATUS_EINVAL when the 'sem_id' is not valid
+ *      OS_STATUS_EERR when any other error has occurred
+ * =====================================================================================
+ */
+int OS_CountSemGiveMany (uint32_t sem_id, uint32_t count)
+{
+    rtems_status_code rtems_ret = RTEMS_SUCCESSFUL;
+
+    _CHECK_COUNTSEM_INIT();
+
+    /* Check Parameters */
+
+    if(sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    for( ; (count > 0) && (rtems_ret == RTEMS_SUCCESSFUL); count-- )
+        rtems_ret = rtems_semaphore_release(OS_count_sem_table[sem_id].id);
+
+    ASSERT(rtems_ret == RTEMS_SUCCESSFUL );
+    switch( rtems_ret )
+    {
+        case RTEMS_NOT_OWNER_OF_RESOURCE:
+        case RTEMS_INVALID_ID: os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+        case RTEMS_SUCCESSFUL: return 0;
+        default: os_return_minus_one_and_set_errno(OS_STATUS_EERR);
+    }
+
+    return  OS_STATUS_EERR;
+
+}/* end OS_CountSemGiveMany */
+
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  OS_CoundSemTake
@@ -446,6 +486,47 @@ int OS_CountSemTryTake (uint32_t sem_id)
 
 }/* end OS_CountSemTryTake */
 
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  OS_CountSemTryTakeMany
+ *  Description:  The function takes without waiting up to 'count' units of
+ *  the semaphore 'sem_id'
+ *  Parameters:
+ *      -sem_id:    semaphore identifier.
+ *      -count:     maximum number of units to take
+ *      -taken:     number of units taken
+ *  Return:
+ *      0 when the function success
+ *      OS_STATUS_EINVAL when the parameters are not valid
+ *      OS_STATUS_SEM_FAILURE when any other error has occurred
+ * =====================================================================================
+ */
+int OS_CountSemTryTakeMany (uint32_t sem_id, uint32_t count, uint32_t *taken)
+{
+    rtems_status_code status;
+
+    _CHECK_COUNTSEM_INIT();
+
+    /* Check Parameters */
+
+    if(sem_id >= OS_MAX_COUNT_SEMAPHORES  || OS_count_sem_table[sem_id].free == TRUE)
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+    if( taken == NULL )
+        os_return_minus_one_and_set_errno(OS_STATUS_EINVAL);
+
+    for( *taken = 0; *taken < count; (*taken)++ )
+    {
+        status = rtems_semaphore_obtain(
+                OS_count_sem_table[sem_id].id, RTEMS_NO_WAIT, RTEMS_NO_TIMEOUT);
+        if( status == RTEMS_UNSATISFIED ) break;
+        if( status != RTEMS_SUCCESSFUL )
+            os_return_minus_one_and_set_errno(OS_STATUS_SEM_FAILURE);
+    }
+
+    return 0;
+
+}/* end OS_CountSemTryTakeMany */
+
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  OS_CountSemGetInfo